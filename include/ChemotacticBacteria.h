@@ -18,24 +18,33 @@
  * @since       1.0
  */
 
-#ifndef PAQS_H_
-#define PAQS_H_
+#ifndef CHEMOTACTICBACTERIA_H_
+#define CHEMOTACTICBACTERIA_H_
 
-#include "agent.h"
+#include "composedAgent.h"
 #include "EPS.h"
 
 namespace BNSim {
 
-class ChemotacticBacteria: public Agent {
+class ChemotacticBacteria: public ComposedAgent<ChemotaxisSystem>,
+		public PooledObject<ChemotacticBacteria> {
 public:
 	ChemotacticBacteria(const myVector3d& absPosition, double radius, double shovek, double volocity);
 	virtual ~ChemotacticBacteria();
 	virtual void update();
+	// update() of a batch of chemotactic bacteria through the population kernel
+	static void updateBatch(Agent** agents, unsigned long n);
 private:
 	bool _active;
     double _velocity;
 };
 
+template<>
+inline void staticUpdateKernel<ChemotacticBacteria>(Agent** agents,
+		unsigned long n) {
+	ChemotacticBacteria::updateBatch(agents, n);
+}
+
 } /* namespace BNSim */
 
-#endif /* PAQS_H_ */
+#endif /* CHEMOTACTICBACTERIA_H_ */
@@ -26,7 +26,7 @@
 
 namespace BNSim {
 
-class EPS: public Agent {
+class EPS: public Agent, public PooledObject<EPS> {
 public:
 	EPS(const myVector3d& absPosition,EPSType type, double radius, double shovek);
 	virtual ~EPS();
@@ -39,4 +39,4 @@ private:
 
 } /* namespace BNSim */
 
-#endif /* PAQS_H_ */
+#endif /* EPS_H_ */
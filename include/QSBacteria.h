@@ -21,12 +21,13 @@
 #ifndef PAQS_H_
 #define PAQS_H_
 
-#include "agent.h"
+#include "composedAgent.h"
 #include "EPS.h"
 
 namespace BNSim {
 
-class QSBacteria: public Agent {
+class QSBacteria: public ComposedAgent<QSLux, SimpleMetabolism>,
+		public PooledObject<QSBacteria> {
 public:
 	QSBacteria(const myVector3d& absPosition, double radius, double shovek, double T_div, double T_eps, double T_die);
 	virtual ~QSBacteria();
@@ -22,9 +22,13 @@
 #define AGENT_H_
 
 #include "common.h"
+#include "componentRegistry.h"
 #include "regulatoryNet.h"
 #include "configuration.h"
 #include "spacegrid.h"
+#include "agentStore.h"
+#include "agentTypes.h"
+#include "massRegistry.h"
 #include <vector>
 #include <cmath>
 
@@ -45,48 +49,131 @@ public:
 	virtual ~Agent();
 	virtual void update();
 	virtual void pos_update();
+	// asleep agents stay put and only act as obstacles in the mechanics
+	bool isAsleep();
 	intVector3d getGridPos() {
 		return _gridPosition;
 	}
 
 	double getShovek() {
-		return _shovek;
+		return _store->shovek(_handle);
 	}
-	myVector3d& getabsPosition() {
-		return _absPosition;
+	myVector3d getabsPosition() {
+		return myVector3d(_store->posX(_handle), _store->posY(_handle),
+				_store->posZ(_handle));
+	}
+	void setabsPosition(const myVector3d& position) {
+		_store->posX(_handle) = position.pos.x;
+		_store->posY(_handle) = position.pos.y;
+		_store->posZ(_handle) = position.pos.z;
 	}
 	double getDistance(Agent& agentB);
 	bool updateMass(const std::string& name, double mass);
 	double getMass(const std::string& name);
-	double getCellRadius() const {
-		return _cell_radius;
+	// set the mass of a component the agent carries, volumes follow
+	bool updateMass(unsigned int slot, double mass) {
+		if (_density[slot] == 0)
+			return false;
+		double deltaVolume = (mass - _mass[slot]) / _density[slot];
+		_total_volume += deltaVolume;
+		if (MassRegistry::isCellMass(slot))
+			_volume += deltaVolume;
+		_mass[slot] = mass;
+		return true;
 	}
-	double getTotalRadius() const {
-		return _total_radius;
+	// mass of a component, -1 if the agent does not carry it
+	double getMass(unsigned int slot) {
+		return _density[slot] == 0 ? -1 : _mass[slot];
 	}
-	void updateVolume();
-	void updateRadius() {
-		_total_radius = pow(_total_volume * 0.75 / 3.141592653, 0.33);
-		_cell_radius = pow(_volume * 0.75 / 3.141592653, 0.33);
+	double getCellRadius() {
+		return _store->cellRadius(_handle);
 	}
+	double getTotalRadius() {
+		return _store->totalRadius(_handle);
+	}
+	void updateVolume();
+	void updateRadius();
 	unsigned long getID() const {
 		return ID;
 	}
+	agentHandle getHandle() const {
+		return _handle;
+	}
+	unsigned int getAgentType() {
+		return _store->type(_handle);
+	}
+	unsigned int getGridCell() {
+		return _store->gridCell(_handle);
+	}
+	// position in the universe's agent list, maintained by AgentContainer
+	unsigned long getListIndex() const {
+		return _listIndex;
+	}
+	void setListIndex(unsigned long index) {
+		_listIndex = index;
+	}
 	RegulatoryNet * getRegulatoryNet(const std::string& name);
+	// typed access to a network, NULL if the agent does not carry one
+	template<typename T>
+	T* getComponent() {
+		unsigned int id = componentID<T>();
+		return id == invalidComponent ? NULL : static_cast<T*>(_components[id]);
+	}
+	// called by the universe when a (new born) agent is committed
+	void attachToUniverse(unsigned long id);
+	// called by the universe before a dead agent is deleted
+	void detachFromUniverse();
 protected:
-	myVector3d _absPosition, _deltaMovement;
 	intVector3d _gridPosition;
 	std::vector<RegulatoryNet *> _nets;
-	std::vector<massInfo *> massInfos;
+	RegulatoryNet* _components[kMaxComponentTypes];
+	// take ownership of a network and make it reachable by its type
+	template<typename T>
+	T* addNet(T* net) {
+		unsigned int id = componentID<T>();
+		_nets.push_back(net);
+		ComponentRegistry::bind(net, id);
+		if (id != invalidComponent)
+			_components[id] = net;
+		return net;
+	}
+	// give up a network without deleting it
+	void removeNet(RegulatoryNet* net);
 	void updateGridPos();
 	void registerGridPos();
-	void deRegisterGridPos();
-	void shove();
+	void updateNetworks();
 	void addMass(const std::string& name, double mass, double density);
-	double _total_radius, _cell_radius, _shovek, _total_volume, _volume; // volume: vol without EPS
+	void addMass(unsigned int slot, double mass, double density);
+	void setAgentType(unsigned int type) {
+		_store->type(_handle) = type;
+	}
+	void setCellRadius(double radius) {
+		_store->cellRadius(_handle) = radius;
+	}
+	void setTotalRadius(double radius) {
+		_store->totalRadius(_handle) = radius;
+	}
+	// immobile agents still push others away but are not pushed themselves
+	void setMobile(bool mobile) {
+		_store->mobility(_handle) = mobile ? 1 : 0;
+	}
+	// accumulate a displacement that is applied in pos_update()
+	void addMovement(const myVector3d& delta) {
+		_store->deltaX(_handle) += delta.pos.x;
+		_store->deltaY(_handle) += delta.pos.y;
+		_store->deltaZ(_handle) += delta.pos.z;
+	}
+	double _total_volume, _volume; // volume: vol without EPS
+	// mass components by slot, a zero density marks an absent component
+	double _mass[kMaxMassSlots];
+	double _density[kMaxMassSlots];
 	unsigned long ID;
+	AgentStore* _store;
+	agentHandle _handle;
+	unsigned long _listIndex;
 private:
 	Grid* myGrid;
+	intVector3d computeGridPos();
 };
 
 }
@@ -0,0 +1,72 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef AGENTCONTAINER_H_
+#define AGENTCONTAINER_H_
+
+#include <vector>
+
+namespace BNSim {
+
+class Agent;
+
+const unsigned int kAgentChunkShift = 12;
+const unsigned int kAgentChunkSize = 1 << kAgentChunkShift;
+const unsigned int kAgentChunkMask = kAgentChunkSize - 1;
+const unsigned int kMaxAgentChunks = 1 << 14;
+
+/*
+ * AgentContainer is the universe's list of agents. It grows chunk by chunk,
+ * so existing slots never move and nothing is copied when it grows.
+ * Removed agents leave a NULL tombstone whose slot is handed out again to
+ * the next agent, and compact() squeezes the tombstones out (optionally
+ * ordering the survivors by grid cell) to keep iteration dense.
+ */
+
+class AgentContainer {
+public:
+	AgentContainer();
+	~AgentContainer();
+	Agent*& operator[](unsigned long i) {
+		return _chunks[i >> kAgentChunkShift][i & kAgentChunkMask];
+	}
+	// number of slots, including tombstones
+	unsigned long getSize() const { return _size; }
+	// number of live agents
+	unsigned long getCount() const { return _size - _freeSlots.size(); }
+	unsigned long add(Agent* agent);
+	void remove(Agent* agent);
+	// reserve n slots for a batch of agents, reusing tombstones first
+	void reserveSlots(unsigned long n, std::vector<unsigned long>& slots);
+	void place(unsigned long slot, Agent* agent);
+	bool needsCompaction() const;
+	void compact(bool spatialOrder);
+private:
+	Agent*** _chunks;
+	unsigned long _chunkCount;
+	unsigned long _size;
+	std::vector<unsigned long> _freeSlots;
+	unsigned long append();
+	void releaseChunks(unsigned long keep);
+};
+
+} /* namespace BNSim */
+
+#endif /* AGENTCONTAINER_H_ */
@@ -0,0 +1,121 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef AGENTSTORE_H_
+#define AGENTSTORE_H_
+
+#include <vector>
+#include <mutex>
+#include "common.h"
+
+namespace BNSim {
+
+class Agent;
+
+typedef unsigned int agentHandle;
+
+// type tag of agents without a statically dispatched kernel, see agentTypes.h
+const unsigned int genericAgent = 0;
+
+const unsigned int kAgentBlockShift = 10;
+const unsigned int kAgentBlockSize = 1 << kAgentBlockShift;
+const unsigned int kAgentBlockMask = kAgentBlockSize - 1;
+const unsigned int kMaxAgentBlocks = 1 << 16;  // 64M agents
+const agentHandle invalidHandle = 0xffffffff;
+
+/*
+ * One block of the agent store. Every column is a contiguous, cache-line
+ * aligned array so that mechanics kernels can stream over a block.
+ */
+
+struct AgentBlock {
+	double x[kAgentBlockSize], y[kAgentBlockSize], z[kAgentBlockSize];
+	double dx[kAgentBlockSize], dy[kAgentBlockSize], dz[kAgentBlockSize];
+	double totalRadius[kAgentBlockSize];
+	double cellRadius[kAgentBlockSize];
+	double shovek[kAgentBlockSize];
+	double mobility[kAgentBlockSize];
+	unsigned int idleSteps[kAgentBlockSize];
+	unsigned int gridCell[kAgentBlockSize];
+	unsigned int type[kAgentBlockSize];
+	Agent* owner[kAgentBlockSize];
+	// by handle: the row holding the agent; by row: the handle stored there
+	agentHandle row[kAgentBlockSize];
+	agentHandle handle[kAgentBlockSize];
+};
+
+/*
+ * AgentStore keeps the mechanical core of every agent (position,
+ * displacement, radii, shove constant, mobility, idle steps, grid cell and
+ * type tag) in structure-of-arrays form. Agents refer to their row through
+ * a stable handle. Blocks are never moved once allocated, so other threads
+ * can keep reading while the store grows. Between steps reorder() may move
+ * the rows, e.g. into spatial order, without invalidating any handle. Until
+ * it does, a handle is its own row and the accessors skip the row table.
+ */
+
+class AgentStore {
+public:
+	AgentStore();
+	~AgentStore();
+	agentHandle acquire(Agent* owner);
+	void release(agentHandle h);
+	// number of rows ever handed out, i.e. upper bound for live handles
+	unsigned int getHighWater() const { return _highWater; }
+	std::size_t getLiveCount() const { return _highWater - _freeList.size(); }
+	unsigned int getBlockCount() const { return _blockCount; }
+	AgentBlock* getBlock(unsigned int i) { return _blocks[i]; }
+	agentHandle row(agentHandle h) const { return _reordered ? _blocks[h >> kAgentBlockShift]->row[h & kAgentBlockMask] : h; }
+	agentHandle handleAt(agentHandle r) const { return _blocks[r >> kAgentBlockShift]->handle[r & kAgentBlockMask]; }
+	// move the rows of the given live handles to the front, in that order
+	void reorder(const agentHandle* handles, unsigned long n);
+
+	double& posX(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->x[r & kAgentBlockMask]; }
+	double& posY(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->y[r & kAgentBlockMask]; }
+	double& posZ(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->z[r & kAgentBlockMask]; }
+	double& deltaX(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->dx[r & kAgentBlockMask]; }
+	double& deltaY(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->dy[r & kAgentBlockMask]; }
+	double& deltaZ(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->dz[r & kAgentBlockMask]; }
+	double& totalRadius(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->totalRadius[r & kAgentBlockMask]; }
+	double& cellRadius(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->cellRadius[r & kAgentBlockMask]; }
+	double& shovek(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->shovek[r & kAgentBlockMask]; }
+	// 1 if contacts displace the agent, 0 if it is a fixed obstacle
+	double& mobility(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->mobility[r & kAgentBlockMask]; }
+	// steps the agent stayed put, see Agent::isAsleep()
+	unsigned int& idleSteps(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->idleSteps[r & kAgentBlockMask]; }
+	unsigned int& gridCell(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->gridCell[r & kAgentBlockMask]; }
+	unsigned int& type(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->type[r & kAgentBlockMask]; }
+	Agent*& owner(agentHandle h) { agentHandle r = row(h); return _blocks[r >> kAgentBlockShift]->owner[r & kAgentBlockMask]; }
+private:
+	AgentBlock** _blocks;
+	unsigned int _blockCount;
+	unsigned int _highWater;
+	bool _reordered;   // rows were moved, handles must go through row[]
+	std::vector<agentHandle> _freeList;
+	std::mutex locker;
+	void addBlock();
+	template<typename T>
+	void permute(T (AgentBlock::*column)[kAgentBlockSize],
+			const std::vector<agentHandle>& from);
+};
+
+} /* namespace BNSim */
+
+#endif /* AGENTSTORE_H_ */
@@ -0,0 +1,81 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef AGENTTYPES_H_
+#define AGENTTYPES_H_
+
+#include <typeinfo>
+#include <mutex>
+
+namespace BNSim {
+
+class Agent;
+
+// updates a batch of agents that all have the same concrete type
+typedef void (*agentKernel)(Agent** agents, unsigned long n);
+
+const unsigned int kMaxAgentTypes = 256;
+
+/*
+ * Registry of concrete agent types. Each registered type gets a small
+ * integer tag (stored in the agent store) and a statically dispatched
+ * update kernel, so the universe can update agents type by type. Type 0
+ * is the generic fallback that goes through the virtual Agent::update().
+ */
+
+class AgentTypeRegistry {
+public:
+	static unsigned int add(const std::type_info& info, agentKernel kernel);
+	static unsigned int getTypeCount() { return typeCount; }
+	static agentKernel getKernel(unsigned int type) { return types[type].kernel; }
+	static const std::type_info& getTypeInfo(unsigned int type) { return *types[type].info; }
+private:
+	struct typeRecord {
+		const std::type_info* info;
+		agentKernel kernel;
+	};
+	// fixed table, so readers never see it move while a type registers
+	static typeRecord types[kMaxAgentTypes];
+	static unsigned int typeCount;
+	static std::mutex locker;
+};
+
+template<typename T>
+void staticUpdateKernel(Agent** agents, unsigned long n) {
+	for (unsigned long i = 0; i != n; ++i)
+		static_cast<T*>(agents[i])->T::update();
+}
+
+/*
+ * Type tag of T, registered on first use. A new cell type in the zoo
+ * opts in by calling setAgentType(agentTypeID<MyCell>()) in its
+ * constructor; MyCell::update() must then be the complete update of the
+ * agent.
+ */
+template<typename T>
+unsigned int agentTypeID() {
+	static unsigned int id = AgentTypeRegistry::add(typeid(T),
+			&staticUpdateKernel<T>);
+	return id;
+}
+
+} /* namespace BNSim */
+
+#endif /* AGENTTYPES_H_ */
@@ -0,0 +1,76 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef CELLINDEX_H_
+#define CELLINDEX_H_
+
+#include <vector>
+#include <atomic>
+#include "agentStore.h"
+
+namespace BNSim {
+
+const unsigned int noCell = 0xffffffff;
+
+/*
+ * CellIndex is a flat cell-linked list: the items of cell c are
+ * getItems()[getStart(c)] .. getItems()[getStart(c + 1) - 1].
+ * It is rebuilt from scratch by a parallel counting sort, so it needs no
+ * locks and never holds stale entries.
+ */
+
+class CellIndex {
+public:
+	CellIndex();
+	~CellIndex();
+	// items whose key is noCell are left out
+	void build(unsigned int cellCount, const unsigned int* keys,
+			const agentHandle* items, unsigned long n, unsigned int threads);
+	unsigned int getCellCount() const { return _cellCount; }
+	unsigned int getStart(unsigned int cell) const { return _start[cell]; }
+	unsigned int getCount(unsigned int cell) const {
+		return _cellCount == 0 ? 0 : _start[cell + 1] - _start[cell];
+	}
+	const agentHandle* getItems() const { return &_items[0]; }
+	unsigned long getItemCount() const { return _cellCount == 0 ? 0 : _start[_cellCount]; }
+private:
+	struct task_t {
+		CellIndex* index;
+		unsigned long begin, end;     // item range
+		unsigned int cellBegin, cellEnd;  // cell range
+		unsigned int sum;
+	};
+	unsigned int _cellCount;
+	std::vector<unsigned int> _start;
+	std::atomic<unsigned int>* _fill;
+	unsigned int _fillSize;
+	std::vector<agentHandle> _items;
+	const unsigned int* _keys;
+	const agentHandle* _source;
+	static void* count_thread(void* arg);
+	static void* sum_thread(void* arg);
+	static void* scan_thread(void* arg);
+	static void* scatter_thread(void* arg);
+	void run(void* (*fn)(void*), std::vector<task_t>& tasks);
+};
+
+} /* namespace BNSim */
+
+#endif /* CELLINDEX_H_ */
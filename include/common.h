@@ -34,11 +34,64 @@ struct doubleVector3d {
 	double x, y, z;
 };
 
-struct massInfo {
-	std::string name;
-	double mass;
-	double density;
-};
+// spread the low 21 bits of v so that two zero bits follow each of them
+inline unsigned long long spreadBits(unsigned int v) {
+	unsigned long long x = v & 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffull;
+	x = (x | x << 16) & 0x1f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+// Z-order (Morton) key of a cell: sorting by it keeps nearby cells together
+inline unsigned long long mortonKey(unsigned int x, unsigned int y,
+		unsigned int z) {
+	return spreadBits(x) << 2 | spreadBits(y) << 1 | spreadBits(z);
+}
+
+/*
+ * cos and sin of an angle. Below 0.1 rad, as in rotational diffusion with
+ * small timesteps, Taylor polynomials replace the library calls; their
+ * error stays under 2e-9.
+ */
+inline void sinCos(double angle, double& sine, double& cosine) {
+	if (fabs(angle) < 0.1) {
+		double a2 = angle * angle;
+		cosine = 1 - a2 * (0.5 - a2 * (1.0 / 24));
+		sine = angle * (1 - a2 * (1.0 / 6 - a2 * (1.0 / 120)));
+	} else {
+		cosine = cos(angle);
+		sine = sin(angle);
+	}
+}
+
+/*
+ * Turn the unit vector (x, y, z) by theta towards the part of r that is
+ * perpendicular to it, i.e. rotate it about the axis v x r. With v a unit
+ * vector, v x r x v is just r minus its projection on v, so no cross
+ * product or rotation matrix is needed. The result is brought back to unit
+ * length by a Newton step instead of a square root.
+ */
+inline void rotatePerpendicular(double& x, double& y, double& z, double theta,
+		double rx, double ry, double rz) {
+	double along = x * rx + y * ry + z * rz;
+	double px = rx - along * x, py = ry - along * y, pz = rz - along * z;
+	double length2 = px * px + py * py + pz * pz;
+	if (length2 == 0)
+		return;
+	double sine, cosine;
+	sinCos(theta, sine, cosine);
+	double s = sine / sqrt(length2);
+	x = cosine * x + s * px;
+	y = cosine * y + s * py;
+	z = cosine * z + s * pz;
+	double unit = 1.5 - 0.5 * (x * x + y * y + z * z);
+	x *= unit;
+	y *= unit;
+	z *= unit;
+}
 
 enum layerType {
 	bulk, boundary, biofilm
@@ -70,6 +123,11 @@ public:
 	void scale(double s);
 	void scale(double s, const myVector3d& v);
 	void cross(const myVector3d& v1, const myVector3d& v2);
+	// for unit vectors: turn by theta towards the perpendicular part of r
+	void rotatePerp(double theta, const myVector3d& r) {
+		rotatePerpendicular(pos.x, pos.y, pos.z, theta, r.pos.x, r.pos.y,
+				r.pos.z);
+	}
 	doubleVector3d pos;
 };
 
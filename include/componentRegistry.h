@@ -0,0 +1,120 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef COMPONENTREGISTRY_H_
+#define COMPONENTREGISTRY_H_
+
+#include <typeinfo>
+#include <vector>
+#include <mutex>
+
+namespace BNSim {
+
+class RegulatoryNet;
+
+const unsigned int kMaxComponentTypes = 16;
+const unsigned int invalidComponent = kMaxComponentTypes;
+const unsigned long notAttached = (unsigned long) -1;
+
+/*
+ * Doubles of hot state a network type keeps in the dense state array of
+ * its component, see RegulatoryNet::publishState(). Specialized next to the
+ * network types whose population observables are exported.
+ */
+template<typename T>
+struct componentWidth {
+	static const unsigned int value = 0;
+};
+
+/*
+ * Registry of regulatory network types. Each network type gets a small
+ * component ID, which indexes the typed component table of an agent. For
+ * the networks of every agent in the universe the registry keeps, per
+ * type, a dense index of pointers and a dense state array with one
+ * contiguous row of hot state per network, in the same order. Observables
+ * over a whole population are a linear scan of the state array; the
+ * networks themselves stay inline in their agents for the update kernels.
+ */
+
+class ComponentRegistry {
+public:
+	static unsigned int add(const std::type_info& info, unsigned int width);
+	static unsigned int getTypeCount() { return typeCount; }
+	// tag a network with its component ID, done once by its host
+	static void bind(RegulatoryNet* net, unsigned int id);
+	// enter/leave the pointer index of the network's type
+	static void attach(RegulatoryNet* net);
+	static void detach(RegulatoryNet* net);
+	static unsigned long getCount(unsigned int id) { return components[id].dense.size(); }
+	static RegulatoryNet* get(unsigned int id, unsigned long i) { return components[id].dense[i]; }
+	// row i of the state array, NULL for types without state
+	static double* getState(unsigned int id, unsigned long i) {
+		componentRecord& record = components[id];
+		return record.width == 0 ? NULL : &record.state[i * record.width];
+	}
+private:
+	struct componentRecord {
+		const std::type_info* info;
+		unsigned int width;
+		std::vector<RegulatoryNet*> dense;
+		std::vector<double> state;   // width doubles per entry of dense
+		std::mutex locker;
+	};
+	static componentRecord components[kMaxComponentTypes];
+	static unsigned int typeCount;
+	static std::mutex locker;
+};
+
+/*
+ * Component ID of network type T, registered on first use.
+ */
+template<typename T>
+unsigned int componentID() {
+	static unsigned int id = ComponentRegistry::add(typeid(T),
+			componentWidth<T>::value);
+	return id;
+}
+
+// number of T networks attached to agents of the universe
+template<typename T>
+unsigned long componentCount() {
+	unsigned int id = componentID<T>();
+	return id == invalidComponent ? 0 : ComponentRegistry::getCount(id);
+}
+
+// hot state of every T network, componentWidth<T>::value doubles each and
+// in the order of componentAt<T>(); NULL while there is none
+template<typename T>
+const double* componentState() {
+	unsigned int id = componentID<T>();
+	if (id == invalidComponent || ComponentRegistry::getCount(id) == 0)
+		return NULL;
+	return ComponentRegistry::getState(id, 0);
+}
+
+// i-th T network of the population, in no particular order
+template<typename T>
+T* componentAt(unsigned long i) {
+	return static_cast<T*>(ComponentRegistry::get(componentID<T>(), i));
+}
+
+} /* namespace BNSim */
+
+#endif /* COMPONENTREGISTRY_H_ */
@@ -0,0 +1,98 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef COMPOSEDAGENT_H_
+#define COMPOSEDAGENT_H_
+
+#include "agent.h"
+#include <tuple>
+#include <type_traits>
+
+namespace BNSim {
+
+/*
+ * ComposedAgent declares an agent type as a compile-time list of regulatory
+ * networks, e.g. ComposedAgent<QSLux, SimpleMetabolism>. The networks are
+ * stored inline in the agent and updatePipeline() calls their update() in
+ * the declared order without virtual dispatch, so a type registered with
+ * agentTypeID<> gets its whole biology inlined into its batch kernel.
+ * Networks are also entered in _nets and the component table, so runtime
+ * lookups, exporters and addNet() for prototyping keep working.
+ */
+
+template<typename ... Nets>
+class ComposedAgent: public Agent {
+public:
+	ComposedAgent(const myVector3d& absPosition, double radius, double shovek) :
+			Agent(absPosition, radius, shovek), _pipeline(hostOf<Nets>(this)...) {
+		registerNets<0>();
+	}
+	virtual ~ComposedAgent() {
+		// the networks are members, so Agent must not delete them
+		unregisterNets<0>();
+	}
+	template<std::size_t I>
+	typename std::tuple_element<I, std::tuple<Nets...> >::type& getNet() {
+		return std::get<I>(_pipeline);
+	}
+protected:
+	void updatePipeline() {
+		updateNet<0>();
+	}
+private:
+	std::tuple<Nets...> _pipeline;
+
+	template<typename T>
+	static Agent* hostOf(Agent* host) {
+		return host;
+	}
+
+	template<std::size_t I>
+	typename std::enable_if<I < sizeof...(Nets)>::type updateNet() {
+		typedef typename std::tuple_element<I, std::tuple<Nets...> >::type net_t;
+		std::get<I>(_pipeline).net_t::update();
+		updateNet<I + 1>();
+	}
+	template<std::size_t I>
+	typename std::enable_if<I == sizeof...(Nets)>::type updateNet() {
+	}
+
+	template<std::size_t I>
+	typename std::enable_if<I < sizeof...(Nets)>::type registerNets() {
+		addNet(&std::get<I>(_pipeline));
+		registerNets<I + 1>();
+	}
+	template<std::size_t I>
+	typename std::enable_if<I == sizeof...(Nets)>::type registerNets() {
+	}
+
+	template<std::size_t I>
+	typename std::enable_if<I < sizeof...(Nets)>::type unregisterNets() {
+		removeNet(&std::get<I>(_pipeline));
+		unregisterNets<I + 1>();
+	}
+	template<std::size_t I>
+	typename std::enable_if<I == sizeof...(Nets)>::type unregisterNets() {
+	}
+};
+
+} /* namespace BNSim */
+
+#endif /* COMPOSEDAGENT_H_ */
@@ -39,6 +39,21 @@ public:
 	static std::string workdir ;
 	static unsigned int boundaryLayerThickness;
     static bool diffusion;  // simulate diffusion or not
+    static unsigned int compactionInterval;  // steps between agent list compactions, 0: only when sparse
+    static bool spatialCompaction;  // order the agent list and store in Z-order of the grid cells when compacting
+    static bool mortonGrids;  // number the grids in Z-order instead of row by row
+    static double verletSkin;  // extra range of the contact lists in micrometers, 0: rebuild every step
+    static unsigned int relaxationSweeps;  // contact sweeps per step at most, 1: a single push
+    static double overlapTolerance;  // sweeps stop once no overlap exceeds this, in micrometers
+    static bool contactBVH;  // find contacts with a bounding volume hierarchy instead of uniform bins
+    static unsigned int sleepSteps;  // idle steps before an agent falls asleep, 0: never
+    static double sleepDisplacement;  // largest movement per step that counts as idle, in micrometers
+    static double wakeOverlap;  // summed overlap with moving agents that wakes a sleeping one
+    static bool freezeInactive;  // replace inactive cells by fixed obstacles
+    static bool eventMotor;  // switch flagellar motors at sampled event times (rates per second) and swim the runs in between, instead of a draw per step (rates as probabilities per step)
+    static bool fastChemotaxisMath;  // approximate exp and log and tabulate the motor rates in the batched chemotaxis update
+    static bool fastRadiusMath;  // approximate pow when radii are computed from volumes
+    static unsigned long long randomSeed;  // seed of the random streams of the agent threads
 };
 
 }
@@ -0,0 +1,56 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef CONTACTKERNELS_H_
+#define CONTACTKERNELS_H_
+
+namespace BNSim {
+
+/*
+ * Packed agents and half neighbor lists handed to a contact kernel. The
+ * kernel adds the displacements of the agents in [begin, end) and of their
+ * listed neighbors to delta, interleaved by four: x, y, z and the summed
+ * overlap of the agent. Only pairs with a mobile agent are evaluated. The
+ * kernel returns the largest overlap among them.
+ */
+
+struct contactBlock {
+	const double* x;
+	const double* y;
+	const double* z;
+	const double* radius;
+	const double* mobility;
+	const unsigned long* listStart;
+	const unsigned int* neighbors;
+	double* delta;
+};
+
+typedef double (*contactKernel)(const contactBlock& block, unsigned long begin,
+		unsigned long end);
+
+double scalarContactKernel(const contactBlock& block, unsigned long begin,
+		unsigned long end);
+
+// the fastest kernel the running CPU supports, chosen once
+contactKernel getContactKernel();
+
+} /* namespace BNSim */
+
+#endif /* CONTACTKERNELS_H_ */
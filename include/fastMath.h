@@ -0,0 +1,112 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef FASTMATH_H_
+#define FASTMATH_H_
+
+#include <cmath>
+#include <cstring>
+
+namespace BNSim {
+
+/*
+ * Branch-free approximations of the transcendental functions used by the
+ * biology kernels. They are plain arithmetic on doubles, so loops over
+ * columns can be vectorized, and they assume finite arguments in the ranges
+ * noted below. Measured maximum relative errors:
+ *
+ *   fastExp   x in [-708, 709]          5e-13
+ *   fastLog   x positive and normal     2e-12
+ *   fastPow   x positive and normal     5e-13 + 1e-15 |y log x|
+ *   fastCbrt  x positive and normal     1e-15
+ */
+
+// exp by 2^n e^r with |r| <= ln2 / 2, the Taylor series of e^r to degree 10
+inline double fastExp(double x) {
+	x = x < -708.0 ? -708.0 : (x > 709.0 ? 709.0 : x);
+	double n = floor(x * 1.4426950408889634 + 0.5);
+	double r = x - n * 0.6931471803691238 - n * 1.9082149292705877e-10;
+	double p = 1 + r * (1 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24
+			+ r * (1.0 / 120 + r * (1.0 / 720 + r * (1.0 / 5040
+			+ r * (1.0 / 40320 + r * (1.0 / 362880
+			+ r * (1.0 / 3628800))))))))));
+	unsigned long long bits = (unsigned long long) (n + 1023) << 52;
+	double scale;
+	memcpy(&scale, &bits, sizeof(scale));
+	return p * scale;
+}
+
+// log by e ln2 + log m with m in [sqrt(1/2), sqrt(2)), series in (m-1)/(m+1)
+inline double fastLog(double x) {
+	unsigned long long bits;
+	memcpy(&bits, &x, sizeof(bits));
+	double e = (double) (bits >> 52) - 1023;
+	bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+	double m;
+	memcpy(&m, &bits, sizeof(m));
+	double high = m > 1.4142135623730951 ? 1.0 : 0.0;
+	m *= 1 - 0.5 * high;
+	e += high;
+	double s = (m - 1) / (m + 1), s2 = s * s;
+	double p = 2 * s * (1 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7
+			+ s2 * (1.0 / 9 + s2 * (1.0 / 11 + s2 * (1.0 / 13)))))));
+	return p + e * 0.6931471805599453;
+}
+
+inline double fastPow(double x, double y) {
+	return fastExp(y * fastLog(x));
+}
+
+// a guess from the exponent divided by three, refined by Newton steps
+inline double fastCbrt(double x) {
+	unsigned long long bits;
+	memcpy(&bits, &x, sizeof(bits));
+	bits = bits / 3 + 0x2a9f7893782da1ceULL;
+	double y;
+	memcpy(&y, &bits, sizeof(y));
+	y = (2 * y + x / (y * y)) * (1.0 / 3);
+	y = (2 * y + x / (y * y)) * (1.0 / 3);
+	y = (2 * y + x / (y * y)) * (1.0 / 3);
+	y = (2 * y + x / (y * y)) * (1.0 / 3);
+	return y;
+}
+
+/*
+ * Precision policies: a kernel written as a template over Math calls
+ * Math::exp and friends and is instantiated once for each policy.
+ */
+
+struct ExactMath {
+	static double exp(double x) { return std::exp(x); }
+	static double log(double x) { return std::log(x); }
+	static double pow(double x, double y) { return std::pow(x, y); }
+	static double cbrt(double x) { return std::cbrt(x); }
+};
+
+struct FastMath {
+	static double exp(double x) { return fastExp(x); }
+	static double log(double x) { return fastLog(x); }
+	static double pow(double x, double y) { return fastPow(x, y); }
+	static double cbrt(double x) { return fastCbrt(x); }
+};
+
+} /* namespace BNSim */
+
+#endif /* FASTMATH_H_ */
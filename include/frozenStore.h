@@ -0,0 +1,50 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef FROZENSTORE_H_
+#define FROZENSTORE_H_
+
+#include <vector>
+#include <cstddef>
+
+namespace BNSim {
+
+/*
+ * FrozenStore keeps what is left of agents taken out of the simulation
+ * that still occupy space, such as inactive cells: position and radius
+ * only, in structure-of-arrays form. They have no networks and are never
+ * updated; the mechanics treats them as fixed obstacles.
+ */
+
+class FrozenStore {
+public:
+	void add(double x, double y, double z, double radius);
+	std::size_t getCount() const { return _x.size(); }
+	const double* getX() const { return _x.empty() ? NULL : &_x[0]; }
+	const double* getY() const { return _y.empty() ? NULL : &_y[0]; }
+	const double* getZ() const { return _z.empty() ? NULL : &_z[0]; }
+	const double* getRadius() const { return _radius.empty() ? NULL : &_radius[0]; }
+private:
+	std::vector<double> _x, _y, _z, _radius;
+};
+
+} /* namespace BNSim */
+
+#endif /* FROZENSTORE_H_ */
@@ -0,0 +1,54 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef INVERSECDF_H_
+#define INVERSECDF_H_
+
+#include <vector>
+
+namespace BNSim {
+
+/*
+ * Sampler for a fixed one-dimensional distribution: the inverse of its
+ * cumulative distribution is tabulated once, and sample() turns a single
+ * uniform number into a draw by linear interpolation in the table. The
+ * density is integrated numerically on [lo, hi], so it need not be
+ * normalized, and mass outside the range is dropped as if rejected.
+ */
+
+class InverseCDF {
+public:
+	InverseCDF(double (*density)(double x), double lo, double hi,
+			unsigned int size = 4096);
+	// draw for a uniform u in [0, 1)
+	double sample(double u) const {
+		double position = u * _scale;
+		unsigned int i = (unsigned int) position;
+		double fraction = position - i;
+		return _quantile[i] + fraction * (_quantile[i + 1] - _quantile[i]);
+	}
+private:
+	std::vector<double> _quantile;   // size + 1 points of equal probability
+	double _scale;
+};
+
+} /* namespace BNSim */
+
+#endif /* INVERSECDF_H_ */
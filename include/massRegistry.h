@@ -0,0 +1,65 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef MASSREGISTRY_H_
+#define MASSREGISTRY_H_
+
+#include <string>
+#include <mutex>
+
+namespace BNSim {
+
+const unsigned int kMaxMassSlots = 8;
+
+// slots of the mass components used by the built-in agents
+const unsigned int biomassSlot = 0;   // "X", cell biomass
+const unsigned int epsSlot = 1;       // "EPS", capsule, not part of the cell volume
+
+const unsigned int invalidMassSlot = 0xffffffff;
+
+/*
+ * Registry of mass components. Every component name is resolved once to a
+ * small integer slot, and agents keep their masses in a fixed array indexed
+ * by slot. Components that are not cell mass (EPS) only add to the total
+ * volume of an agent.
+ */
+
+class MassRegistry {
+public:
+	// slot of name, registered on first use; invalidMassSlot if the table is full
+	static unsigned int getSlot(const std::string& name, bool cellMass = true);
+	// slot of name, or invalidMassSlot if it was never registered
+	static unsigned int findSlot(const std::string& name);
+	static unsigned int getSlotCount() { return slotCount; }
+	static const std::string& getName(unsigned int slot) { return slots[slot].name; }
+	static bool isCellMass(unsigned int slot) { return slots[slot].cellMass; }
+private:
+	struct slotRecord {
+		std::string name;
+		bool cellMass;
+	};
+	static slotRecord slots[kMaxMassSlots];
+	static unsigned int slotCount;
+	static std::mutex locker;
+};
+
+} /* namespace BNSim */
+
+#endif /* MASSREGISTRY_H_ */
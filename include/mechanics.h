@@ -0,0 +1,190 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef MECHANICS_H_
+#define MECHANICS_H_
+
+#include <vector>
+#include <cmath>
+#include "agentStore.h"
+#include "cellIndex.h"
+#include "sphereBVH.h"
+#include "frozenStore.h"
+
+namespace BNSim {
+
+typedef unsigned long long binKey;
+
+/*
+ * Mechanics resolves the overlaps between agents once per step. Contacts
+ * come from Verlet neighbor lists: a list holds every agent within the sum
+ * of both radii plus CONFIG::verletSkin, and is reused until an agent moved
+ * (or grew) enough to possibly bring a new pair into contact, or the
+ * population changed. Lists are half lists in CSR form over a compact
+ * index of the agents, so every pair is stored and evaluated once and
+ * gets equal and opposite displacements.
+ *
+ * Lists are built with a spatial hash: bins are cubes of the largest
+ * interaction distance, so every candidate lies in the 27 bins around an
+ * agent. Bins are hashed into a table sized to the population, which keeps
+ * the memory independent of the world size; a bucket may hold agents of
+ * several bins, so candidates are filtered by their bin key.
+ *
+ * With CONFIG::contactBVH the candidates come from a bounding volume
+ * hierarchy instead, which does not depend on one bin size and so suits
+ * populations mixing large cells and small EPS particles. While the
+ * population stays the same the tree is only refitted to the moved agents,
+ * and rebuilt once refitting made it much looser than when it was built.
+ *
+ * A step may run up to CONFIG::relaxationSweeps contact sweeps on a packed
+ * copy of the positions, until no overlap exceeds CONFIG::overlapTolerance.
+ * The lists are rebuilt between sweeps if the agents drifted out of the
+ * skin, and the total relaxation is added to the agents' movement.
+ *
+ * Sleeping agents (see Agent::isAsleep()) take part as fixed obstacles, and
+ * pairs of two of them are skipped. A sleeping agent whose overlaps with
+ * moving agents add up to more than CONFIG::wakeOverlap is woken up.
+ *
+ * The frozen agents follow the live ones in the compact index. They have
+ * no lists of their own and enter the contacts only as fixed obstacles.
+ */
+
+class Mechanics {
+public:
+	Mechanics(AgentStore& store, const FrozenStore& frozen);
+	// called by the universe after every step with the live agents
+	void refresh(const agentHandle* handles, unsigned long n,
+			unsigned int threads, bool populationChanged);
+	// add the contact displacements of the listed agents to their movement
+	void resolve(unsigned int threads);
+	double getBinSize() const { return _binSize; }
+	unsigned long getListBuilds() const { return _listBuilds; }
+	unsigned long getPairCount() const { return _listStart.empty() ? 0 : _listStart.back(); }
+	unsigned long getTreeBuilds() const { return _treeBuilds; }
+	// relaxation of the last step. Overlaps are measured by the sweeps, so
+	// when the sweep limit ends the step, the residual is the overlap the
+	// last sweep found before its push was applied and isConverged() is
+	// false even if that push cleared it; measuring again would cost a
+	// further contact pass.
+	unsigned int getSweeps() const { return _sweeps; }
+	double getInitialOverlap() const { return _initialOverlap; }
+	double getResidualOverlap() const { return _residualOverlap; }
+	bool isConverged() const { return _converged; }
+	unsigned long getSleepingCount() const { return _sleeping; }
+private:
+	AgentStore& _store;
+	const FrozenStore& _frozen;
+	double _skin;
+	double _binSize, _inverseBinSize;
+	unsigned int _bucketMask;
+	CellIndex _bins;
+	std::vector<unsigned int> _keys;
+	std::vector<unsigned int> _items;
+	std::vector<binKey> _binOf;   // bin by compact index at the last build
+	SphereBVH _tree;   // over the compact index, if CONFIG::contactBVH
+	bool _useTree;
+	double _treeCost;   // cost of the tree right after its last build
+	unsigned long _treeBuilds;
+
+	// live agents of the lists by compact index, and their half lists
+	std::vector<agentHandle> _handles;
+	std::vector<unsigned long> _listStart;
+	std::vector<unsigned int> _neighbors;
+	// position and radius of every agent at the last build, frozen included
+	std::vector<double> _refX, _refY, _refZ, _refRadius;
+	unsigned long _listBuilds;
+
+	// packed copy of the agents for the contact kernel, frozen included
+	std::vector<double> _x, _y, _z, _radius, _mobility;
+	std::vector<double> _pressure;   // summed overlap of the finished sweeps
+	std::vector<unsigned char> _asleep;
+	unsigned long _sleeping;
+	// displacements accumulated by each thread
+	std::vector<std::vector<double> > _buffers;
+	unsigned int _sweeps;
+	double _initialOverlap, _residualOverlap;
+	bool _converged;
+
+	struct task_t {
+		Mechanics* mechanics;
+		unsigned int index;
+		unsigned long begin, end;
+		std::vector<unsigned int> neighbors;
+		double drift;
+		double overlap;
+		unsigned long sleeping;
+	};
+
+	bool needsRebuild(unsigned int threads);
+	void rebin(unsigned int threads);
+	void updateTree(bool populationChanged);
+	void buildLists(const agentHandle* handles, unsigned long n,
+			unsigned int threads, bool populationChanged);
+	void listFromReferences(unsigned int threads, bool populationChanged);
+	double sweep(std::vector<task_t>& tasks, unsigned int threads);
+	void split(std::vector<task_t>& tasks, unsigned int threads);
+	static void* drift_thread(void* arg);
+	static void* list_thread(void* arg);
+	static void* gather_thread(void* arg);
+	static void* contact_thread(void* arg);
+	static void* move_thread(void* arg);
+	static void* apply_thread(void* arg);
+	static void run(void* (*fn)(void*), std::vector<task_t>& tasks);
+
+	long binOf(double x) const {
+		return x > 0 ? (long) (x * _inverseBinSize) : 0;
+	}
+	static binKey makeKey(long x, long y, long z) {
+		return ((binKey) x << 42) | ((binKey) y << 21) | (binKey) z;
+	}
+	unsigned int hash(binKey key) const {
+		return (unsigned int) ((key >> 42) * 73856093u
+				^ ((key >> 21) & 0x1fffff) * 19349663u
+				^ (key & 0x1fffff) * 83492791u) & _bucketMask;
+	}
+	// call visit(j) for every other agent in the 27 bins around agent i
+	template<typename Visitor>
+	void forEachCandidate(unsigned int i, Visitor visit) const {
+		const unsigned int* items = _bins.getItems();
+		long bx = binOf(_refX[i]), by = binOf(_refY[i]), bz = binOf(_refZ[i]);
+
+		for (long x = bx - 1; x <= bx + 1; ++x) {
+			for (long y = by - 1; y <= by + 1; ++y) {
+				for (long z = bz - 1; z <= bz + 1; ++z) {
+					if (x < 0 || y < 0 || z < 0)
+						continue;
+					binKey key = makeKey(x, y, z);
+					unsigned int bucket = hash(key);
+					unsigned int end = _bins.getStart(bucket)
+							+ _bins.getCount(bucket);
+					for (unsigned int k = _bins.getStart(bucket); k != end; ++k) {
+						unsigned int j = items[k];
+						if (j != i && _binOf[j] == key)
+							visit(j);
+					}
+				}
+			}
+		}
+	}
+};
+
+} /* namespace BNSim */
+
+#endif /* MECHANICS_H_ */
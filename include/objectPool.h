@@ -0,0 +1,223 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef OBJECTPOOL_H_
+#define OBJECTPOOL_H_
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "mutexlock.h"
+
+namespace BNSim {
+
+/*
+ * Keeps track of every typed pool so that the universe can hand all slabs
+ * back to the system in one go when it is destroyed.
+ */
+
+class ObjectPoolRegistry {
+public:
+	static void add(void (*release)());
+	static void releaseAll();
+	static unsigned int getGeneration() {
+		return generation().load(std::memory_order_relaxed);
+	}
+private:
+	static std::atomic<unsigned int>& generation();
+	static std::vector<void (*)()>& pools();
+	static std::mutex& locker();
+};
+
+/*
+ * Typed object pool: objects are carved out of slabs of kSlabObjects
+ * entries, and every thread keeps its own free list so that allocation
+ * and release in the agent threads do not touch the global allocator.
+ * A thread's free list is handed back to the pool when the thread exits.
+ */
+
+template<typename T>
+class ObjectPool {
+public:
+	static void* allocate() {
+		Cache& c = cache();
+		if (c.generation != ObjectPoolRegistry::getGeneration())
+			c.reset();
+		if (c.head == NULL)
+			refill(c);
+
+		FreeNode* node = c.head;
+		c.head = node->next;
+		c.count--;
+		return node;
+	}
+
+	static void deallocate(void* p) {
+		Cache& c = cache();
+		if (c.generation != ObjectPoolRegistry::getGeneration())
+			c.reset();
+
+		FreeNode* node = (FreeNode*) p;
+		node->next = c.head;
+		c.head = node;
+		if (++c.count > kMaxCached)
+			c.flush(kMaxCached / 2);
+	}
+
+	// Free all slabs. Every object of this type must be destroyed already.
+	static void releaseSlabs() {
+		State& s = state();
+		mutexLock lock(s.locker);
+		for (std::size_t i = 0; i != s.slabs.size(); ++i)
+			free(s.slabs[i]);
+		s.slabs.clear();
+		s.freeHead = NULL;
+	}
+
+private:
+	struct FreeNode {
+		FreeNode* next;
+	};
+
+	static const std::size_t kSlabObjects = 256;
+	static const std::size_t kRefill = 64;
+	static const std::size_t kMaxCached = 1024;
+	static const std::size_t kAlign = 16;
+	static const std::size_t kChunk = ((sizeof(T) > sizeof(FreeNode) ?
+			sizeof(T) : sizeof(FreeNode)) + kAlign - 1) / kAlign * kAlign;
+
+	struct State {
+		State() : freeHead(NULL), registered(false) {}
+		std::mutex locker;
+		std::vector<char*> slabs;
+		FreeNode* freeHead;
+		bool registered;
+	};
+
+	struct Cache {
+		Cache() : head(NULL), count(0),
+				generation(ObjectPoolRegistry::getGeneration()) {}
+		~Cache() {
+			if (generation == ObjectPoolRegistry::getGeneration())
+				flush(count);
+		}
+		void reset() {
+			head = NULL;
+			count = 0;
+			generation = ObjectPoolRegistry::getGeneration();
+		}
+		// give n nodes back to the shared free list
+		void flush(std::size_t n) {
+			if (n == 0 || head == NULL)
+				return;
+			FreeNode* first = head;
+			FreeNode* last = head;
+			std::size_t moved = 1;
+			while (moved < n && last->next != NULL) {
+				last = last->next;
+				moved++;
+			}
+			head = last->next;
+			count -= moved;
+
+			State& s = state();
+			mutexLock lock(s.locker);
+			last->next = s.freeHead;
+			s.freeHead = first;
+		}
+		FreeNode* head;
+		std::size_t count;
+		unsigned int generation;
+	};
+
+	static State& state() {
+		static State s;
+		return s;
+	}
+
+	static Cache& cache() {
+		static thread_local Cache c;
+		return c;
+	}
+
+	static void refill(Cache& c) {
+		State& s = state();
+		mutexLock lock(s.locker);
+
+		if (!s.registered) {
+			ObjectPoolRegistry::add(&ObjectPool<T>::releaseSlabs);
+			s.registered = true;
+		}
+
+		// take a batch from the shared free list first
+		while (s.freeHead != NULL && c.count < kRefill) {
+			FreeNode* node = s.freeHead;
+			s.freeHead = node->next;
+			node->next = c.head;
+			c.head = node;
+			c.count++;
+		}
+		if (c.head != NULL)
+			return;
+
+		// otherwise carve a new slab
+		char* slab = (char*) malloc(kSlabObjects * kChunk);
+		if (slab == NULL)
+			throw std::bad_alloc();
+		s.slabs.push_back(slab);
+
+		for (std::size_t i = kSlabObjects; i-- != 0;) {
+			FreeNode* node = (FreeNode*) (slab + i * kChunk);
+			node->next = c.head;
+			c.head = node;
+		}
+		c.count += kSlabObjects;
+	}
+};
+
+/*
+ * Inherit from PooledObject<T> to route new/delete of T through
+ * ObjectPool<T>. Classes deriving from T with a different size fall back
+ * to the global allocator.
+ */
+
+template<typename T>
+class PooledObject {
+public:
+	static void* operator new(std::size_t size) {
+		if (size != sizeof(T))
+			return ::operator new(size);
+		return ObjectPool<T>::allocate();
+	}
+	static void operator delete(void* p, std::size_t size) {
+		if (p == NULL)
+			return;
+		if (size != sizeof(T))
+			::operator delete(p);
+		else
+			ObjectPool<T>::deallocate(p);
+	}
+};
+
+} /* namespace BNSim */
+
+#endif /* OBJECTPOOL_H_ */
@@ -0,0 +1,65 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef RANDOMSTREAM_H_
+#define RANDOMSTREAM_H_
+
+namespace BNSim {
+
+/*
+ * Uniform random numbers in bulk for population kernels. Four xorshift128+
+ * generators run side by side, so fill() advances four independent lanes
+ * per iteration without a dependency between them. Every thread gets its
+ * own stream. The agent threads are created anew every step, so they
+ * restart theirs from (CONFIG::randomSeed, step, worker index), which keeps
+ * the draws independent of the order the threads happen to start in.
+ */
+
+class RandomStream {
+public:
+	explicit RandomStream(unsigned long long seed);
+	// n uniform numbers in [0, 1)
+	void fill(double* u, unsigned long n);
+	double next();
+	// restart the stream, one of many drawn from the same seed
+	void seed(unsigned long long seed, unsigned long long step,
+			unsigned int stream);
+	static RandomStream& local();
+private:
+	static const unsigned int kLanes = 4;
+	unsigned long long _s0[kLanes], _s1[kLanes];
+	unsigned int _lane;
+	static unsigned long long step(unsigned long long& s0,
+			unsigned long long& s1) {
+		unsigned long long x = s0;
+		unsigned long long y = s1;
+		s0 = y;
+		x ^= x << 23;
+		s1 = x ^ y ^ (x >> 17) ^ (y >> 26);
+		return s1 + y;
+	}
+	static double toUniform(unsigned long long r) {
+		return (r >> 11) * (1.0 / 9007199254740992.0);
+	}
+};
+
+} /* namespace BNSim */
+
+#endif /* RANDOMSTREAM_H_ */
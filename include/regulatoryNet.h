@@ -22,31 +22,81 @@
 #define REGULATORYNET_H_
 
 
+#include "componentRegistry.h"
 #include "configuration.h"
+#include "objectPool.h"
 #include <string>
 
 namespace BNSim {
 
 class Agent;
 class SimpleMetabolism;
+class RandomStream;
 
 class RegulatoryNet {
 public:
 	RegulatoryNet(Agent* host);
 	virtual ~RegulatoryNet();
 	virtual void update() = 0;
+	// resolve the molecule species the network reads, when its host is attached
+	virtual void bindSpecies() {}
 	Agent* getHost() { return _host;}
     std::string& getName() {return name;}
+	unsigned int getComponentType() const { return _componentType; }
 protected:
 	Agent* _host;
     std::string name;
+	// copy the hot state into its row of the type's dense state array
+	virtual void publishState() {}
+	// that row, NULL while not attached or for types without state
+	double* stateRow() {
+		return _denseIndex == notAttached ? NULL :
+				ComponentRegistry::getState(_componentType, _denseIndex);
+	}
+private:
+	friend class ComponentRegistry;
+	unsigned int _componentType;
+	unsigned long _denseIndex;   // position in the pointer index of its type
+};
+
+/*
+ * Rate and binding constants of QSLux. They are identical across a
+ * population, so networks share one immutable block instead of a copy each.
+ */
+
+struct QSLuxParams {
+	QSLuxParams();
+	static const QSLuxParams& defaults();
+
+	// define rate constants
+	double kA1;
+	double kA2;
+	double kR1;
+	double kR2;
+	double kS;
+	double CR1;
+	double CR2;
+	double CA1;
+	double CA2;
+	double CS;
+
+	// define binding constants
+	double KL1;
+	double KL2;
+	double KL3;
+	double KL4;
+	double KS1;
+	double KS;
+	double KR1;
+	double k[13];
 };
 
-class QSLux: public RegulatoryNet {
+class QSLux: public RegulatoryNet, public PooledObject<QSLux> {
 public:
-	QSLux(Agent* host);
+	QSLux(Agent* host, const QSLuxParams* params = &QSLuxParams::defaults());
 	virtual ~QSLux();
 	virtual void update();
+	virtual void bindSpecies();
 	bool isActivated() { return activated; }
 	double getA1() { return A1;}
 	double getR1() { return R1;}
@@ -54,6 +104,11 @@ public:
 	double getR2() { return R2;}
     double getC1() { return C1;}
 	double getC2() { return C2;}
+	// layout of the hot state, see componentState<QSLux>()
+	enum { stateR1, stateC1, stateA1, stateWidth };
+
+protected:
+	virtual void publishState();
 
 private:
 	// las
@@ -75,93 +130,90 @@ private:
 	double qsi2;
 	double qsi3;
 
-	// define rate constants
-	double kA1;
-	double kA2;
-	double kR1;
-	double kR2;
-	double kS;
-	double CR1;
-	double CR2;
-	double CA1;
-	double CA2;
-	double CS;
-
-	// define binding constants
-	double KL1;
-	double KL2;
-	double KL3;
-	double KL4;
-	double KS1;
-	double KS;
-	double KR1;
-	double k[13];
+	const QSLuxParams* _params;
 
 	bool activated;
 
+	// species indices, -1 if absent
+	int QSI1, QSI2, QSI3, AIIndex;
+
     double randomUniform();
 };
 
-class SimpleMetabolism: public RegulatoryNet {
+template<>
+struct componentWidth<QSLux> {
+	static const unsigned int value = QSLux::stateWidth;
+};
+
+/*
+ * Constants of SimpleMetabolism, shared by all networks of a cell type.
+ */
+
+struct MetabolismParams {
+	MetabolismParams();
+	static const MetabolismParams& defaults();
+	double m, u_PG, u_PGMax;
+	double Y;
+	double u_max; // substrate
+	double Ks, Kc;
+};
+
+class SimpleMetabolism: public RegulatoryNet,
+		public PooledObject<SimpleMetabolism> {
 private:
-	double _m,_u_PG,_u_PGMax;
-	double _Y;
-	double _u,_u_max; // substrate
-	double _Ks,_Kc;
+	const MetabolismParams* _params;
+	double _u; // substrate
 	QSLux *_qs;
 	double _s;
+	int substrate;   // species index, -1 if absent
 	void grow();
     double randomUniform();
 public:
-	SimpleMetabolism(Agent* host);
+	SimpleMetabolism(Agent* host,
+			const MetabolismParams* params = &MetabolismParams::defaults());
 	virtual ~SimpleMetabolism();
 	virtual void update();
+	virtual void bindSpecies();
 	double getS() const {	return _s;}
 	double getU() const {	return _u;	}
-	void setU(double u) {	_u = u;	}
-	double getMaintenance() const {	return _m;	}
-	void setMaintenance(double maintenance) {	_m = maintenance;	}
-	double getuMax() const {	return _u_max;	}
-	void setuMax(double max) {	_u_max = max;	}
-	double getPg() const {	return _u_PG;	}
-	void setPg(double pg) {	_u_PG = pg;	}
-	double getY() const {	return _Y;	}
-	void setY(double y) {	_Y = y;	}
+	void setU(double u) {	_u = u;	publishState();	}
+	const MetabolismParams* getParams() const {	return _params;	}
+	void setParams(const MetabolismParams* params) {	_params = params;	}
+	double getMaintenance() const {	return _params->m;	}
+	double getuMax() const {	return _params->u_max;	}
+	double getPg() const {	return _params->u_PG;	}
+	double getY() const {	return _params->Y;	}
 	const QSLux* getQs() const { return _qs;	}
 	void setQs(QSLux* qs) {	_qs = qs;	}
-	double getKc() const {	return _Kc;	}
-	void setKc(double kc) {	_Kc = kc;	}
-	double getKs() const {	return _Ks;	}
-	void setKs(double ks) {	_Ks = ks;}
-	double getPgMax() const {	return _u_PGMax;	}
-	void setPgMax(double pgMax) {	_u_PGMax = pgMax;	}
+	double getKc() const {	return _params->Kc;	}
+	double getKs() const {	return _params->Ks;	}
+	double getPgMax() const {	return _params->u_PGMax;	}
+	// layout of the hot state, see componentState<SimpleMetabolism>()
+	enum { stateS, stateU, stateWidth };
+protected:
+	virtual void publishState();
 };
 
-class ChemotaxisSystem : public RegulatoryNet{
-public:
-    ChemotaxisSystem(Agent* host);
-    virtual void update();
-    void rotationalDiffusion();
-    double tumbleAngle();
-    void tumble();
-    double sampleGamma(double k, double theta);
-    void rotatePerp(myVector3d& v, double theta);
-    void rotate(myVector3d& v, myVector3d axis, double theta);
-    bool isCCW() {return CCW;}
-    void setDirection(const myVector3d& dir) { direction = dir;};
-    const myVector3d& getDirection() { return direction;}
-private:
-    double Y;
+template<>
+struct componentWidth<SimpleMetabolism> {
+	static const unsigned int value = SimpleMetabolism::stateWidth;
+};
+
+/*
+ * Receptor, adaptation and motor constants of ChemotaxisSystem, shared by
+ * the whole population.
+ */
+
+struct ChemotaxisParams {
+    ChemotaxisParams();
+    static const ChemotaxisParams& defaults();
     double Ya;
     double Ye;
     double H;
     double inverseTau;
     double kr;
     double kb;
-    double m;
     double m0;
-    double aspcon;
-    double activity;
     double alpha;
     double KA;
     double KI;
@@ -170,16 +222,46 @@ private:
     double g0;
     double g1;
     double w;
+};
+
+class ChemotaxisSystem : public RegulatoryNet,
+		public PooledObject<ChemotaxisSystem> {
+public:
+    ChemotaxisSystem(Agent* host,
+            const ChemotaxisParams* params = &ChemotaxisParams::defaults());
+    virtual void update();
+    virtual void bindSpecies();
+    // same as update() for every network, computed column by column
+    static void updateBatch(ChemotaxisSystem** nets, unsigned long n);
+    void rotationalDiffusion();
+    double tumbleAngle();
+    void tumble();
+    void rotatePerp(myVector3d& v, double theta);
+    bool isCCW() {return CCW;}
+    void setDirection(const myVector3d& dir) { direction = dir;};
+    const myVector3d& getDirection() { return direction;}
+    // path of the last step in units of velocity * dt, with CONFIG::eventMotor
+    const myVector3d& getTravel() { return travel;}
+private:
+    const ChemotaxisParams* _params;
+    double Y;
+    double m;
+    double aspcon;
+    double activity;
     bool CCW;
     myVector3d direction;
+    int Aspartate;   // species index, -1 if absent
     double randomUniform();
 
     // motor
+    double switchClock;   // hazard left until the next switch, see CONFIG::eventMotor
+    myVector3d travel;
     double tau;
     double runtime;
     double tumbletime;
     double kPlus();
     double kMinus();
+    void eventStep(double kPlus, double kMinus, double dt, RandomStream& random);
 };
 
 } /* namespace BNSim */
@@ -41,13 +41,10 @@ public:
     void setConc(const unsigned int moleculeSpeciesIndex, const double conc);
     void consumeChemical(const unsigned int moleculeSpeciesIndex, const double conc);
 	void updateParticles();
-	const std::size_t getAgentNumber() { return _agents->getCount(); }
-	void addAgent(Agent* p) ;
-	void deleteAgent(Agent* p);
+	const std::size_t getAgentNumber();
 	void deltaChemical(const unsigned int moleculeSpeciesIndex, const double mass);
 	layerType getLayerType() {return _type;}
 	void setLayerType(layerType type) {_type = type; }
-	BNSimVector<Agent*> *_agents;
 private:
 	unsigned int _gridIndex;
 	double *_moleculeSpeciesConc;
@@ -0,0 +1,91 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#ifndef SPHEREBVH_H_
+#define SPHEREBVH_H_
+
+#include <vector>
+
+namespace BNSim {
+
+/*
+ * Bounding volume hierarchy over spheres, for populations whose radii
+ * differ too much for uniform bins (bacteria next to small EPS particles).
+ * Every sphere is boxed with its radius plus a margin. The tree can be
+ * refitted to moved spheres in one bottom-up pass; getCost() (total
+ * surface of the boxes) tells when a refitted tree got loose enough to be
+ * rebuilt.
+ */
+
+class SphereBVH {
+public:
+	SphereBVH();
+	void build(const double* x, const double* y, const double* z,
+			const double* radius, unsigned long n, double margin);
+	void refit(const double* x, const double* y, const double* z,
+			const double* radius, double margin);
+	unsigned long getItemCount() const { return _items.size(); }
+	double getCost() const { return _cost; }
+
+	// call visit(item) for every sphere whose box overlaps [lo, hi]
+	template<typename Visitor>
+	void query(const double lo[3], const double hi[3], Visitor visit) const {
+		if (_nodes.empty())
+			return;
+		unsigned int stack[64];
+		unsigned int depth = 0;
+		stack[depth++] = 0;
+		while (depth != 0) {
+			const node_t& node = _nodes[stack[--depth]];
+			if (node.hi[0] < lo[0] || node.lo[0] > hi[0]
+					|| node.hi[1] < lo[1] || node.lo[1] > hi[1]
+					|| node.hi[2] < lo[2] || node.lo[2] > hi[2])
+				continue;
+			if (node.count != 0) {
+				for (unsigned int k = node.first; k != node.first + node.count; ++k)
+					visit(_items[k]);
+			} else {
+				stack[depth++] = node.first;
+				stack[depth++] = node.first + 1;
+			}
+		}
+	}
+private:
+	struct node_t {
+		double lo[3], hi[3];
+		unsigned int first;   // first item of a leaf, left child otherwise
+		unsigned int count;   // 0 for inner nodes
+	};
+	static const unsigned int kLeafSize = 4;
+	std::vector<node_t> _nodes;
+	std::vector<unsigned int> _items;
+	std::vector<double> _centers;
+	double _cost;
+
+	void split(unsigned int node, unsigned int begin, unsigned int end,
+			unsigned int depth);
+	void boxItems(node_t& node, const double* x, const double* y,
+			const double* z, const double* radius, double margin);
+	static double surface(const node_t& node);
+};
+
+} /* namespace BNSim */
+
+#endif /* SPHEREBVH_H_ */
@@ -30,6 +30,11 @@
 #include"spacegrid.h"
 #include"moleculeInfo.h"
 #include"agent.h"
+#include"agentStore.h"
+#include"agentContainer.h"
+#include"cellIndex.h"
+#include"frozenStore.h"
+#include"mechanics.h"
 #include"configuration.h"
 
 namespace BNSim {
@@ -41,21 +46,37 @@ class Agent;
 struct thread_data_t {
 	unsigned int start;
 	unsigned int end;
+	unsigned int index;
 };
 
 class Universe {
 public:
 	Universe();
 	virtual ~Universe();
+	// species must be added before the agents, networks bind them once on attach
 	void addMoleculeSpecies(MoleculeInfo* moleculeInfo) { _moleculeMAP[moleculeInfo->getName()]=moleculeInfo; _moleculeMAPIndexed[moleculeInfo->getIndex()]=moleculeInfo;}
 	const MoleculeInfo* getMoleculeInfo (const std::string& name) ;
 	const MoleculeInfo* getMoleculeInfo (const unsigned int index) ;
+	// index of a species, -1 if it is not registered; for setup and binding only
+	int getMoleculeIndex(const std::string& name);
 	void diffuse();
 	Grid* getGrid(unsigned int GridIndex) { return _Grids[GridIndex]; }
 	Grid* getGrid(unsigned int x, unsigned int y, unsigned int z);
-	void addAgent(Agent* agent) { _Agents.add(agent);}
+	unsigned int getGridIndex(unsigned int x, unsigned int y, unsigned int z);
+	AgentStore& getAgentStore() { return _store; }
+	const FrozenStore& getFrozenStore() { return _frozen; }
+	// contact lists, refreshed at the end of each step and resolved after the agent update
+	const Mechanics& getMechanics() { if (_occupancyDirty && !_deferring) rebuild_occupancy(); return _mechanics; }
+	// agents of every grid, rebuilt at the end of each step
+	const CellIndex& getOccupancy() { if (_occupancyDirty && !_deferring) rebuild_occupancy(); return _occupancy; }
+	void addAgent(Agent* agent);
+	void removeAgent(Agent* agent);
+	// replace the agent by a fixed obstacle of its size and delete it
+	void freezeAgent(Agent* agent);
     Agent* getAgent(unsigned int AgentIndex) { if(AgentIndex>=_Agents.getSize()) return NULL; else return _Agents[AgentIndex]; }
+	// upper bound for agent indices; getAgent() returns NULL for removed agents
 	std::size_t getTotalAgentNumber() { return _Agents.getSize();}
+	std::size_t getLiveAgentNumber() { return _Agents.getCount();}
 	void evolute();
 	Grid* getEastGrid(unsigned int x, unsigned int y, unsigned int z);
 	Grid* getWestGrid(unsigned int x, unsigned int y, unsigned int z);
@@ -63,10 +84,14 @@ public:
 	Grid* getDownGrid(unsigned int x, unsigned int y, unsigned int z);
 	Grid* getNorthGrid(unsigned int x, unsigned int y, unsigned int z);
 	Grid* getSouthGrid(unsigned int x, unsigned int y, unsigned int z);
-    unsigned long retriveID() {return IDcounts++;}
+	static unsigned int getWorkerIndex();
 private:
 	std::vector<Grid*> _Grids;
-	BNSimVector<Agent*> _Agents;
+	std::vector<unsigned int> _gridIndex;  // grid number of every cell, row by row
+	AgentContainer _Agents;
+	AgentStore _store;
+	FrozenStore _frozen;
+	Mechanics _mechanics;
 	std::map<std::string,MoleculeInfo*> _moleculeMAP;
 	std::map<unsigned int,MoleculeInfo*> _moleculeMAPIndexed;
 	pthread_t *thr;
@@ -75,7 +100,30 @@ private:
 	void prepare_multithreading();
 	void update_agent_parallel();
 	void update_environment_p();
+	void build_batches();
+	static void* agent_thread(void *arg);
+	static void* post_agent_thread(void *arg);
+	void commit_population_changes();
+	void compact();
+	void number_grids();
+	void freeze(Agent* agent);
+	void rebuild_occupancy();
+	static void* commit_thread(void *arg);
     unsigned long IDcounts;
+    // births and deaths recorded by each worker thread during a step
+    std::vector<std::vector<Agent*> > _birthQueues, _deathQueues, _freezeQueues;
+    std::vector<unsigned long> _birthOffsets, _birthSlots;
+    // live agents grouped by type for the current step
+    std::vector<Agent*> _batch;
+    std::vector<unsigned int> _typeStart;
+    unsigned long _steps;
+    bool _deferring;
+    CellIndex _occupancy;
+    std::vector<unsigned int> _occupancyKeys;
+    std::vector<agentHandle> _occupancyItems;
+    std::vector<agentHandle> _liveHandles;
+    bool _populationChanged;
+    bool _occupancyDirty;
 };
 
 }
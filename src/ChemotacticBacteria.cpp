@@ -23,16 +23,11 @@
 namespace BNSim {
 
 ChemotacticBacteria::ChemotacticBacteria(const myVector3d& absPosition, double radius, double shovek, double velocity) :
-		Agent(absPosition, radius, shovek), _velocity(velocity), _active(true) {
+		ComposedAgent<ChemotaxisSystem>(absPosition, radius, shovek), _velocity(velocity), _active(true) {
 
-	// add a simple chemotaxis network
-    ChemotaxisSystem * chemopathway = new ChemotaxisSystem(this);
+	setAgentType(agentTypeID<ChemotacticBacteria>());
 
-    _nets.push_back(chemopathway);
-
-	_volume = _total_volume = 4 * 3.141592653 * _cell_radius * _cell_radius
-			* _cell_radius / 3;
-    _total_radius =_cell_radius;
+	_volume = _total_volume = 4 * 3.141592653 * radius * radius * radius / 3;
 }
 
 ChemotacticBacteria::~ChemotacticBacteria() {
@@ -43,9 +38,55 @@ void ChemotacticBacteria::update() {
     
 	if (_active) {
         myVector3d velocity1;
-        velocity1.scale(_velocity*CONFIG::timestep, ((ChemotaxisSystem * )_nets[0])->getDirection()); // 30 micrometers/sec
-        _absPosition.add(velocity1);
-		Agent::update();
+        if (CONFIG::eventMotor) {
+            // the network swims the runs of the step, see ChemotaxisSystem::eventStep
+            updatePipeline();
+            velocity1.scale(_velocity*CONFIG::timestep, getNet<0>().getTravel());
+            addMovement(velocity1);
+            return;
+        }
+        velocity1.scale(_velocity*CONFIG::timestep, getNet<0>().getDirection()); // 30 micrometers/sec
+        addMovement(velocity1);
+        updatePipeline();
+	}
+}
+
+/*
+ * Move every active bacterium along its current direction, then update
+ * all their chemotaxis networks at once. With CONFIG::eventMotor the
+ * networks come first and the bacteria follow the runs they swam.
+ */
+void ChemotacticBacteria::updateBatch(Agent** agents, unsigned long n) {
+	static thread_local std::vector<ChemotaxisSystem*> nets;
+	nets.clear();
+	bool events = CONFIG::eventMotor;
+
+	for (unsigned long i = 0; i != n; ++i) {
+		ChemotacticBacteria* bacterium = static_cast<ChemotacticBacteria*>(agents[i]);
+		if (!bacterium->_active)
+			continue;
+		nets.push_back(&bacterium->getNet<0>());
+		if (events)
+			continue;
+		myVector3d velocity1;
+		velocity1.scale(bacterium->_velocity * CONFIG::timestep,
+				bacterium->getNet<0>().getDirection());
+		bacterium->addMovement(velocity1);
+	}
+
+	if (!nets.empty())
+		ChemotaxisSystem::updateBatch(&nets[0], nets.size());
+
+	if (!events)
+		return;
+	for (unsigned long i = 0; i != n; ++i) {
+		ChemotacticBacteria* bacterium = static_cast<ChemotacticBacteria*>(agents[i]);
+		if (!bacterium->_active)
+			continue;
+		myVector3d velocity1;
+		velocity1.scale(bacterium->_velocity * CONFIG::timestep,
+				bacterium->getNet<0>().getTravel());
+		bacterium->addMovement(velocity1);
 	}
 }
 
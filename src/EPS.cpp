@@ -26,14 +26,11 @@ EPS::EPS(const myVector3d& absPosition, EPSType type, double radius,
 		double shovek) :
 		Agent(absPosition, radius, shovek), _type(type) {
 
-	// add cell mass
-	addMass("EPS", 10, 75);   // density g.L-1
+	setAgentType(agentTypeID<EPS>());
 
-	// initialize EPS mass volume
-	_volume = _total_volume = 4 * 3.141592653 * radius * radius * radius / 3;
-
-	// EPS has only one type of mass
-	massInfos[0]->mass = _volume * massInfos[0]->density;
+	// EPS has only one type of mass, filling the initial volume
+	double volume = 4 * 3.141592653 * radius * radius * radius / 3;
+	addMass(epsSlot, volume * 75, 75);   // density g.L-1
 
 	updateRadius();
 }
@@ -43,11 +40,11 @@ EPS::~EPS() {
 }
 
 double EPS::getEPSMass() {
-	return massInfos[0]->mass;
+	return getMass(epsSlot);
 }
 
 void EPS::update() {
-	Agent::update();
+	// EPS carries no regulatory networks, contacts are resolved by the universe
 }
 
 } /* namespace BNSim */
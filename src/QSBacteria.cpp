@@ -22,40 +22,38 @@
 
 namespace BNSim {
 
+// metabolism constants shared by all QS bacteria
+static MetabolismParams qsMetabolismParams() {
+	MetabolismParams params;
+	params.Kc = 0.001;
+	params.Ks = 1;
+	params.m = 1e-4;
+	params.u_max = 0.002;
+	params.u_PGMax = 0.0001;
+	params.Y = 0.85;
+	return params;
+}
+
+static const MetabolismParams qsMetabolism = qsMetabolismParams();
+
 QSBacteria::QSBacteria(const myVector3d& absPosition, double radius, double shovek, double T_div,
 		double T_eps, double T_die) :
-		Agent(absPosition, radius, shovek), _T_div(T_div), _T_eps(T_eps), _T_die(
+		ComposedAgent<QSLux, SimpleMetabolism>(absPosition, radius, shovek), _T_div(T_div), _T_eps(T_eps), _T_die(
 				T_die), _active(true) {
 
-	// add a Lux-type QS network
-	QSLux * qs = new QSLux(this);
-	_nets.push_back(qs);
-
-	// add a simple metabolism network
-            SimpleMetabolism * meta = new SimpleMetabolism(this);
-            meta->setQs(qs);
-            meta->setKc(0.001);
-            meta->setKs(1);
-            meta->setMaintenance(1e-4);
-            meta->setuMax(0.002);
-            meta->setPgMax(0.0001);
-            meta->setY(0.85);
-            _nets.push_back(meta);
-
-	// add cell mass
-	addMass("X", 10, 150);   // density g.L-1
-
-	_volume = _total_volume = 4 * 3.141592653 * _cell_radius * _cell_radius
-			* _cell_radius / 3;
-
-	for (std::vector<massInfo *>::iterator itr = massInfos.begin();
-			itr != massInfos.end(); itr++) {
-		if ((*itr)->name == "X")
-			(*itr)->mass = _volume * (*itr)->density;
-	}
+	// a Lux-type QS network feeding a simple metabolism network
+	SimpleMetabolism& meta = getNet<1>();
+	meta.setParams(&qsMetabolism);
+	meta.setQs(&getNet<0>());
+
+	setAgentType(agentTypeID<QSBacteria>());
+
+	// add cell mass filling the initial volume
+	double volume = 4 * 3.141592653 * radius * radius * radius / 3;
+	addMass(biomassSlot, volume * 150, 150);   // density g.L-1
 
 	// add EPS mass, not adding anything now for the ICC paper
-//	addMass("EPS", 1, 75);
+//	addMass(epsSlot, 1, 75);
 }
 
 QSBacteria::~QSBacteria() {
@@ -64,22 +62,30 @@ QSBacteria::~QSBacteria() {
 
 void QSBacteria::update() {
 	if (_active) {
-		Agent::update();
+		updatePipeline();
 		divide();
 	}
 }
 
 void QSBacteria::divide() {
 
-	if (_cell_radius < _T_die) {
+	double cellRadius = getCellRadius();
+
+	if (cellRadius < _T_die) {
 		// Remain in the space, dead mass
 		_active = false;
+		setMobile(false);
+		if (CONFIG::freezeInactive) {
+			// outside a step this deletes the agent right away
+			CONFIG::universe->freezeAgent(this);
+			return;
+		}
 	}
 
-	if (_cell_radius > _T_div) {
+	if (cellRadius > _T_div) {
 
 		// place my daughter near me
-		myVector3d Position(_absPosition);
+		myVector3d Position(getabsPosition());
 		Position.pos.x = Position.pos.x + 0.01 * ((double) rand() / (RAND_MAX))
 				- 0.005;
 		Position.pos.y = Position.pos.y + 0.01 * ((double) rand() / (RAND_MAX))
@@ -89,22 +95,20 @@ void QSBacteria::divide() {
 
 		// give birth to my daughter
 		Agent* newBac = new QSBacteria(Position, 1.7, 1.2, 2, 2, 0.2);
-		newBac->updateMass("X", getMass("X") * 0.45); // 0.05 for the loss in the division process
-		newBac->updateVolume();
+		newBac->updateMass(biomassSlot, getMass(biomassSlot) * 0.45); // 0.05 for the loss in the division process
 		newBac->updateRadius();
 		CONFIG::universe->addAgent(newBac);
 
 		// cut my mass by half
-		updateMass("X", getMass("X") * 0.45);
-		updateVolume();
+		updateMass(biomassSlot, getMass(biomassSlot) * 0.45);
 		updateRadius();
 	}
 
 	// release an EPS agent from the capsule volume
 
-	if (_total_radius - _cell_radius > _T_eps) {
+	if (getTotalRadius() - getCellRadius() > _T_eps) {
 
-		myVector3d Position(_absPosition);
+		myVector3d Position(getabsPosition());
 		Position.pos.x = Position.pos.x + 0.01 * ((double) rand() / (RAND_MAX))
 				- 0.005;
 		Position.pos.y = Position.pos.y + 0.01 * ((double) rand() / (RAND_MAX))
@@ -112,12 +116,11 @@ void QSBacteria::divide() {
 		Position.pos.z = Position.pos.z + 0.01 * ((double) rand() / (RAND_MAX))
 				- 0.005;
 
-		Agent* newEPS = new EPS(Position, protein, _total_radius - _cell_radius,
-				1.2);
+		Agent* newEPS = new EPS(Position, protein,
+				getTotalRadius() - getCellRadius(), 1.2);
 		CONFIG::universe->addAgent(newEPS);
 
-		updateMass("EPS", 0);
-		updateVolume();
+		updateMass(epsSlot, 0);
 		updateRadius();
 	}
 }
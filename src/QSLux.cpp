@@ -22,27 +22,7 @@
 
 namespace BNSim {
 
-QSLux::QSLux(Agent* host):RegulatoryNet(host){
-	A1 = 0;
-	C1 = 0;
-	S = 0;
-	R1 = 0;
-	R1A1 = 0;
-
-	R1QSI1 = 0;
-
-	// rhl
-	A2 = 0;
-	C2 = 0;
-	R2 = 0;
-	R2A2 = 0;
-
-	// QSI
-
-	qsi1 = 0;
-	qsi2 = 0;
-	qsi3 = 0;
-
+QSLuxParams::QSLuxParams() {
 	// define rate constants
 	kA1 = 2e-3;
 	kA2 = 2e-3;
@@ -70,9 +50,46 @@ QSLux::QSLux(Agent* host):RegulatoryNet(host){
 
 	k[0] = k[7] = 0.01;
 	k[3] = k[10] = k[6] = 0.01;
+}
+
+const QSLuxParams& QSLuxParams::defaults() {
+	static const QSLuxParams params;
+	return params;
+}
+
+QSLux::QSLux(Agent* host, const QSLuxParams* params) :
+		RegulatoryNet(host), _params(params) {
+	A1 = 0;
+	C1 = 0;
+	S = 0;
+	R1 = 0;
+	R1A1 = 0;
+
+	R1QSI1 = 0;
+
+	// rhl
+	A2 = 0;
+	C2 = 0;
+	R2 = 0;
+	R2A2 = 0;
+
+	// QSI
+
+	qsi1 = 0;
+	qsi2 = 0;
+	qsi3 = 0;
 
 	activated = false;
     name = "QSLux";
+
+	QSI1 = QSI2 = QSI3 = AIIndex = -1;
+}
+
+void QSLux::bindSpecies() {
+	QSI1 = CONFIG::universe->getMoleculeIndex("QSI1");
+	QSI2 = CONFIG::universe->getMoleculeIndex("QSI2");
+	QSI3 = CONFIG::universe->getMoleculeIndex("QSI3");
+	AIIndex = CONFIG::universe->getMoleculeIndex("AI");
 }
 
 QSLux::~QSLux() {
@@ -86,24 +103,22 @@ void QSLux::update() {
 
 	//double deltaA1 = (CA1 + kA1*C1*KS1/((KL1+C1)*(KS1+S)) - k[0]*A1 - k[1]*A1*R1 + k[2]*R1A1)*timestep;
 
-	int QSI1 = -1, QSI2 = -1, QSI3 = -1;
-	QSI1 = CONFIG::universe->getMoleculeInfo("QSI1")==NULL?-1:CONFIG::universe->getMoleculeInfo("QSI1")->getIndex();
-	QSI2 = CONFIG::universe->getMoleculeInfo("QSI2")==NULL?-1:CONFIG::universe->getMoleculeInfo("QSI2")->getIndex();
-	QSI3 = CONFIG::universe->getMoleculeInfo("QSI3")==NULL?-1:CONFIG::universe->getMoleculeInfo("QSI3")->getIndex();
 	// now we disable the S feedback
 
 	intVector3d GPos = getHost()->getGridPos();
 
 	Grid* myGrid = CONFIG::universe->getGrid(GPos.x,GPos.y,GPos.z);
 	double timestep = CONFIG::timestep;
+	const QSLuxParams& p = *_params;
+	const double* k = p.k;
 
 	// sense AI
 
 	double myqsi1 = 0, myqsi2 = 0, myqsi3 = 0;
 	double kh = 0.3, g= 2;
 
-	double deltaA1 = (CA1 + kA1*C1/(KL1+C1)- k[0]*A1 - k[1]*A1*R1 + k[2]*R1A1 - A1*myqsi2*kh/(1+g*myqsi2))*timestep;
-	double deltaR1 = ((CR1 + kR1*C1/(KR1+C1))/(1+myqsi3/KL1) - k[3]*R1 - k[1]*A1*R1 - k[1]*myqsi1*R1 + k[2]*R1A1)*timestep;
+	double deltaA1 = (p.CA1 + p.kA1*C1/(p.KL1+C1)- k[0]*A1 - k[1]*A1*R1 + k[2]*R1A1 - A1*myqsi2*kh/(1+g*myqsi2))*timestep;
+	double deltaR1 = ((p.CR1 + p.kR1*C1/(p.KR1+C1))/(1+myqsi3/p.KL1) - k[3]*R1 - k[1]*A1*R1 - k[1]*myqsi1*R1 + k[2]*R1A1)*timestep;
 	double deltaR1A1 = (k[1]*A1*R1 - k[2]*R1A1 -2*k[4]*R1A1*R1A1 + 2*k[5]*C1)*timestep;
 	double deltaR1QSI1 =  (k[1]*myqsi1*R1 - k[2]*R1QSI1)*timestep;
 	double deltaQSI1 =  (- k[1]*myqsi1*R1 + k[2]*R1QSI1)*timestep;
@@ -142,9 +157,6 @@ void QSLux::update() {
 	double agentVolume = getHost()->getTotalRadius()
 			* getHost()->getTotalRadius() * getHost()->getTotalRadius();
 
-	int AIIndex = -1;
-	AIIndex = CONFIG::universe->getMoleculeInfo("AI")==NULL?-1:CONFIG::universe->getMoleculeInfo("AI")->getIndex();
-
 	// Now let's exchange molecules with extracellular space
 	double D = 0.5, ex = 0, delta = 0;
 
@@ -155,6 +167,17 @@ void QSLux::update() {
 		A1 = (A1 * agentVolume-deltaMass)/agentVolume;
 		myGrid->deltaChemical(AIIndex, deltaMass);
 	}
+
+	publishState();
+}
+
+void QSLux::publishState() {
+	double* row = stateRow();
+	if (row == NULL)
+		return;
+	row[stateR1] = R1;
+	row[stateC1] = C1;
+	row[stateA1] = A1;
 }
 
 } /* namespace BNSim */
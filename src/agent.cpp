@@ -19,19 +19,56 @@
  */
 
 #include "agent.h"
+#include "fastMath.h"
 
 namespace BNSim {
 
-Agent::Agent(const myVector3d& absPosition, double radius, double shovek) :
-		_absPosition(absPosition), _cell_radius(radius), _total_radius(radius), _shovek(
-				shovek) {
+Agent::Agent(const myVector3d& absPosition, double radius, double shovek) {
+	_store = &CONFIG::universe->getAgentStore();
+	_handle = _store->acquire(this);
+
+	setabsPosition(absPosition);
+	_store->cellRadius(_handle) = radius;
+	_store->totalRadius(_handle) = radius;
+	_store->shovek(_handle) = shovek;
+
+	// grid registration and ID are assigned when the universe commits us
+	myGrid = NULL;
+	ID = 0;
+	_listIndex = 0;
+
+	for (unsigned int i = 0; i != kMaxComponentTypes; ++i)
+		_components[i] = NULL;
+
+	_total_volume = _volume = 0;
+	for (unsigned int i = 0; i != kMaxMassSlots; ++i)
+		_mass[i] = _density[i] = 0;
+}
+
+void Agent::attachToUniverse(unsigned long id) {
+	ID = id;
 	registerGridPos();
 
-	_deltaMovement.pos.x = 0;
-	_deltaMovement.pos.y = 0;
-	_deltaMovement.pos.z = 0;
+	for (std::vector<RegulatoryNet *>::iterator itr = _nets.begin();
+			itr != _nets.end(); itr++) {
+		(*itr)->bindSpecies();
+		ComponentRegistry::attach(*itr);
+	}
+
+	// a subclass of a registered type that did not register itself must
+	// not be updated by its base class kernel
+	unsigned int type = _store->type(_handle);
+	if (type != genericAgent
+			&& AgentTypeRegistry::getTypeInfo(type) != typeid(*this))
+		_store->type(_handle) = genericAgent;
+}
+
+void Agent::detachFromUniverse() {
+	myGrid = NULL;
 
-	ID = CONFIG::universe->retriveID();
+	for (std::vector<RegulatoryNet *>::iterator itr = _nets.begin();
+			itr != _nets.end(); itr++)
+		ComponentRegistry::detach(*itr);
 }
 
 Agent::~Agent() {
@@ -40,10 +77,20 @@ Agent::~Agent() {
 		delete (*itr);
 	_nets.clear();
 
-	for (std::vector<massInfo *>::iterator itr = massInfos.begin();
-			itr != massInfos.end(); itr++)
-		delete (*itr);
-	massInfos.clear();
+	_store->release(_handle);
+}
+
+void Agent::removeNet(RegulatoryNet* net) {
+	for (std::vector<RegulatoryNet *>::iterator itr = _nets.begin();
+			itr != _nets.end(); itr++) {
+		if (*itr == net) {
+			_nets.erase(itr);
+			break;
+		}
+	}
+	unsigned int id = net->getComponentType();
+	if (id != invalidComponent && _components[id] == net)
+		_components[id] = NULL;
 }
 
 RegulatoryNet* Agent::getRegulatoryNet(const std::string& name) {
@@ -55,83 +102,130 @@ RegulatoryNet* Agent::getRegulatoryNet(const std::string& name) {
 	return NULL;
 }
 
+// contacts are resolved by the universe for all agents after the update
 void Agent::update() {
-	// update regulatory networks
+	updateNetworks();
+	//updateVolume();
+	//updateRadius();
+}
+
+void Agent::updateNetworks() {
 	for (std::vector<RegulatoryNet *>::iterator itr = _nets.begin();
 			itr != _nets.end(); itr++)
 		(*itr)->update();
-
-	shove();
-	//updateVolume();
-	//updateRadius();
 }
 
 void Agent::pos_update() {
-	_absPosition.add(_deltaMovement);
+	double& x = _store->posX(_handle);
+	double& y = _store->posY(_handle);
+	double& z = _store->posZ(_handle);
+	double& dx = _store->deltaX(_handle);
+	double& dy = _store->deltaY(_handle);
+	double& dz = _store->deltaZ(_handle);
+
+	// count the steps the agent stayed put; once asleep it is left alone
+	double limit = CONFIG::sleepDisplacement;
+	unsigned int& idle = _store->idleSteps(_handle);
+	if (dx * dx + dy * dy + dz * dz < limit * limit) {
+		if (isAsleep()) {
+			dx = dy = dz = 0;
+			return;
+		}
+		idle++;
+	} else {
+		idle = 0;
+	}
+
+	x += dx;
+	y += dy;
+	z += dz;
 
 	// check boundaries
-	if (_absPosition.pos.x > CONFIG::worldSizeX) {
-		_absPosition.pos.x = CONFIG::worldSizeX - 1;
+	if (x > CONFIG::worldSizeX) {
+		x = CONFIG::worldSizeX - 1;
 	}
-	if (_absPosition.pos.x < 0) {
-		_absPosition.pos.x = 1;
+	if (x < 0) {
+		x = 1;
 	}
-	if (_absPosition.pos.y > CONFIG::worldSizeY) {
-		_absPosition.pos.y = CONFIG::worldSizeY - 1;
+	if (y > CONFIG::worldSizeY) {
+		y = CONFIG::worldSizeY - 1;
 	}
-	if (_absPosition.pos.y < 0) {
-		_absPosition.pos.y = 1;
+	if (y < 0) {
+		y = 1;
 	}
-	if (_absPosition.pos.z > CONFIG::worldSizeZ) {
-		_absPosition.pos.z = CONFIG::worldSizeZ - 1;
+	if (z > CONFIG::worldSizeZ) {
+		z = CONFIG::worldSizeZ - 1;
 	}
-	if (_absPosition.pos.z < 0) {
-		_absPosition.pos.z = 1;
+	if (z < 0) {
+		z = 1;
 	}
 
 	updateGridPos();
 
-	_deltaMovement.pos.x = 0;
-	_deltaMovement.pos.y = 0;
-	_deltaMovement.pos.z = 0;
+	dx = 0;
+	dy = 0;
+	dz = 0;
 }
 
+bool Agent::isAsleep() {
+	return CONFIG::sleepSteps != 0
+			&& _store->idleSteps(_handle) >= CONFIG::sleepSteps;
+}
+
+/*
+ * Recompute both volumes from scratch. updateMass() keeps them current,
+ * so this is only needed after the masses were changed directly.
+ */
+
 void Agent::updateVolume() {
 	_total_volume = 0;
 	_volume = 0;
 
-	for (std::vector<massInfo *>::iterator itr = massInfos.begin();
-			itr != massInfos.end(); itr++) {
-		_total_volume += (*itr)->mass / (*itr)->density;
-		if ((*itr)->name != "EPS")
-			_volume += (*itr)->mass / (*itr)->density;
+	for (unsigned int i = 0; i != kMaxMassSlots; ++i) {
+		if (_density[i] == 0)
+			continue;
+		_total_volume += _mass[i] / _density[i];
+		if (MassRegistry::isCellMass(i))
+			_volume += _mass[i] / _density[i];
 	}
 }
 
+template<typename Math>
+static double radiusOf(double volume) {
+	return Math::pow(volume * 0.75 / 3.141592653, 0.33);
+}
+
+void Agent::updateRadius() {
+	if (CONFIG::fastRadiusMath) {
+		_store->totalRadius(_handle) = radiusOf<FastMath>(_total_volume);
+		_store->cellRadius(_handle) = radiusOf<FastMath>(_volume);
+	} else {
+		_store->totalRadius(_handle) = radiusOf<ExactMath>(_total_volume);
+		_store->cellRadius(_handle) = radiusOf<ExactMath>(_volume);
+	}
+	// a growing agent pushes its neighbors, keep it awake
+	_store->idleSteps(_handle) = 0;
+}
+
 double Agent::getDistance(Agent& agentB) {
+	agentHandle b = agentB.getHandle();
 
 	double dist = sqrt(
-			pow(_absPosition.pos.x - agentB.getabsPosition().pos.x, 2)
-					+ pow(_absPosition.pos.y - agentB.getabsPosition().pos.y, 2)
-					+ pow(_absPosition.pos.z - agentB.getabsPosition().pos.z,
-							2));
+			pow(_store->posX(_handle) - _store->posX(b), 2)
+					+ pow(_store->posY(_handle) - _store->posY(b), 2)
+					+ pow(_store->posZ(_handle) - _store->posZ(b), 2));
 
 	return dist;
 }
 
-void Agent::deRegisterGridPos() {
-	updateGridPos();
-	myGrid->deleteAgent(this);
-}
-
-void Agent::registerGridPos() {
+intVector3d Agent::computeGridPos() {
 	intVector3d newPos;
 
-	double x = (_absPosition.pos.x + _deltaMovement.pos.x)
+	double x = (_store->posX(_handle) + _store->deltaX(_handle))
 			/ (double) (CONFIG::gridSizeX);
-	double y = (_absPosition.pos.y + _deltaMovement.pos.y)
+	double y = (_store->posY(_handle) + _store->deltaY(_handle))
 			/ (double) (CONFIG::gridSizeY);
-	double z = (_absPosition.pos.z + _deltaMovement.pos.z)
+	double z = (_store->posZ(_handle) + _store->deltaZ(_handle))
 			/ (double) (CONFIG::gridSizeZ);
 
 	double remainderx = (int) (x * 100) % 100;
@@ -158,56 +252,29 @@ void Agent::registerGridPos() {
 	if (newPos.z >= CONFIG::gridNumberZ)
 		newPos.z = CONFIG::gridNumberZ - 1;
 
+	return newPos;
+}
+
+void Agent::registerGridPos() {
+	intVector3d newPos = computeGridPos();
+
 	_gridPosition = newPos;
-	myGrid = CONFIG::universe->getGrid(newPos.x, newPos.y, newPos.z);
-	myGrid->addAgent(this);
+	_store->gridCell(_handle) = CONFIG::universe->getGridIndex(newPos.x,
+			newPos.y, newPos.z);
+	myGrid = CONFIG::universe->getGrid(_store->gridCell(_handle));
 }
 
 void Agent::updateGridPos() {
 
 	try {
-		intVector3d newPos;
-
-		double x = (_absPosition.pos.x + _deltaMovement.pos.x)
-				/ (double) (CONFIG::gridSizeX);
-		double y = (_absPosition.pos.y + _deltaMovement.pos.y)
-				/ (double) (CONFIG::gridSizeY);
-		double z = (_absPosition.pos.z + _deltaMovement.pos.z)
-				/ (double) (CONFIG::gridSizeZ);
-
-		double remainderx = (int) (x * 100) % 100;
-		double remaindery = (int) (y * 100) % 100;
-		double remainderz = (int) (z * 100) % 100;
-
-		if (remainderx >= 50)
-			newPos.x = floor(x) + 1;
-		else
-			newPos.x = floor(x);
-		if (remaindery >= 50)
-			newPos.y = floor(y) + 1;
-		else
-			newPos.y = floor(y);
-		if (remainderz >= 50)
-			newPos.z = floor(z) + 1;
-		else
-			newPos.z = floor(z);
-
-		if (newPos.x >= CONFIG::gridNumberX)
-			newPos.x = CONFIG::gridNumberX - 1;
-		if (newPos.y >= CONFIG::gridNumberY)
-			newPos.y = CONFIG::gridNumberY - 1;
-		if (newPos.z >= CONFIG::gridNumberZ)
-			newPos.z = CONFIG::gridNumberZ - 1;
+		intVector3d newPos = computeGridPos();
 
+		// occupancy lists are rebuilt by the universe after every step
 		if (!(newPos.x == _gridPosition.x && newPos.y == _gridPosition.y
 				&& newPos.z == _gridPosition.z)) {
-			CONFIG::universe->getGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z)->deleteAgent(this);
-
-			myGrid = CONFIG::universe->getGrid(newPos.x, newPos.y, newPos.z);
-			myGrid->addAgent(this);
-
-			//std::cout<<"moving to a new grid"<<std::endl;
+			_store->gridCell(_handle) = CONFIG::universe->getGridIndex(
+					newPos.x, newPos.y, newPos.z);
+			myGrid = CONFIG::universe->getGrid(_store->gridCell(_handle));
 		}
 		_gridPosition = newPos;
 	} catch (...) {
@@ -215,113 +282,36 @@ void Agent::updateGridPos() {
 	}
 }
 
-void Agent::shove() {
-
-	// Get all the grids
-	BNSimVector<Agent*> * gridsArray[7];
-	gridsArray[0] = myGrid->_agents;
-	gridsArray[1] =
-			CONFIG::universe->getEastGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getEastGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-	gridsArray[2] =
-			CONFIG::universe->getWestGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getWestGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-	gridsArray[3] =
-			CONFIG::universe->getNorthGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getNorthGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-	gridsArray[4] =
-			CONFIG::universe->getSouthGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getSouthGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-	gridsArray[5] =
-			CONFIG::universe->getUpGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getUpGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-	gridsArray[6] =
-			CONFIG::universe->getDownGrid(_gridPosition.x, _gridPosition.y,
-					_gridPosition.z) == NULL ?
-					NULL :
-					CONFIG::universe->getDownGrid(_gridPosition.x,
-							_gridPosition.y, _gridPosition.z)->_agents;
-
-	// interactions in my grid and neighboring grids
-	for (unsigned int i = 0; i != 7; ++i) {
-		if (gridsArray[i] == NULL)
-			continue;
-
-		for (unsigned int j = 0; j < (*gridsArray[i]).getSize(); ++j) {
-			Agent * agentB = (*gridsArray[i])[j];
-			try {
-				// make sure it's not me
-				if (agentB == this || agentB == NULL || agentB == nullptr)
-					continue;
-
-				double radiusSum = agentB->getTotalRadius() + _total_radius;
-
-				double distance = getDistance(*agentB);
-
-				// packed
-				if (distance < radiusSum) {
-					myVector3d delta(_absPosition);
-					delta.sub(agentB->getabsPosition());
-					delta.normalize();
-					delta.scale(0.5 * (radiusSum - distance));
-
-					_deltaMovement.add(delta);
-				}
-			} catch (...) {
-				;
-			}
-
-		}
-	}
-}
-
 /*
  * Update biomass
  * return false if no record found
  */
 
 bool Agent::updateMass(const std::string& name, double mass) {
-	for (std::vector<massInfo *>::iterator itr = massInfos.begin();
-			itr != massInfos.end(); itr++) {
-		if (name == (*itr)->name) {
-			(*itr)->mass = mass;
-			return true;
-		}
-	}
-	return false;
+	unsigned int slot = MassRegistry::findSlot(name);
+	if (slot == invalidMassSlot)
+		return false;
+	return updateMass(slot, mass);
 }
 
 double Agent::getMass(const std::string& name) {
-	for (std::vector<massInfo *>::iterator itr = massInfos.begin();
-			itr != massInfos.end(); itr++) {
-		if (name == (*itr)->name) {
-			return (*itr)->mass;
-		}
-	}
-	return -1;
+	unsigned int slot = MassRegistry::findSlot(name);
+	if (slot == invalidMassSlot)
+		return -1;
+	return getMass(slot);
 }
 
 void Agent::addMass(const std::string& name, double mass, double density) {
-	massInfo* newMass = new massInfo;
-	newMass->name = name;
-	newMass->mass = mass;
-	newMass->density = density;
-	massInfos.push_back(newMass);
+	unsigned int slot = MassRegistry::getSlot(name);
+	if (slot != invalidMassSlot)
+		addMass(slot, mass, density);
+}
+
+void Agent::addMass(unsigned int slot, double mass, double density) {
+	// replacing a component takes its old volume out first
+	updateMass(slot, 0);
+	_density[slot] = density;
+	updateMass(slot, mass);
 }
 
 }
@@ -0,0 +1,138 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "agentContainer.h"
+#include "agent.h"
+#include <algorithm>
+#include <utility>
+#include <new>
+
+namespace BNSim {
+
+static bool mortonOrder(const std::pair<unsigned long long, Agent*>& a,
+		const std::pair<unsigned long long, Agent*>& b) {
+	return a.first < b.first;
+}
+
+AgentContainer::AgentContainer() :
+		_chunkCount(0), _size(0) {
+	_chunks = new Agent**[kMaxAgentChunks];
+}
+
+AgentContainer::~AgentContainer() {
+	releaseChunks(0);
+	delete[] _chunks;
+}
+
+void AgentContainer::releaseChunks(unsigned long keep) {
+	while (_chunkCount > keep)
+		delete[] _chunks[--_chunkCount];
+}
+
+unsigned long AgentContainer::append() {
+	if (_size == _chunkCount * kAgentChunkSize) {
+		if (_chunkCount == kMaxAgentChunks)
+			throw std::bad_alloc();
+		_chunks[_chunkCount++] = new Agent*[kAgentChunkSize];
+	}
+	(*this)[_size] = NULL;
+	return _size++;
+}
+
+unsigned long AgentContainer::add(Agent* agent) {
+	unsigned long slot;
+	if (!_freeSlots.empty()) {
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+	} else
+		slot = append();
+
+	place(slot, agent);
+	return slot;
+}
+
+void AgentContainer::place(unsigned long slot, Agent* agent) {
+	(*this)[slot] = agent;
+	agent->setListIndex(slot);
+}
+
+void AgentContainer::remove(Agent* agent) {
+	unsigned long slot = agent->getListIndex();
+	if (slot >= _size || (*this)[slot] != agent)
+		return;
+
+	(*this)[slot] = NULL;
+	_freeSlots.push_back(slot);
+}
+
+void AgentContainer::reserveSlots(unsigned long n,
+		std::vector<unsigned long>& slots) {
+	slots.resize(n);
+	for (unsigned long i = 0; i != n; ++i) {
+		if (!_freeSlots.empty()) {
+			slots[i] = _freeSlots.back();
+			_freeSlots.pop_back();
+		} else
+			slots[i] = append();
+	}
+}
+
+bool AgentContainer::needsCompaction() const {
+	// worth it once a quarter of the slots are tombstones
+	return _freeSlots.size() >= kAgentChunkSize
+			&& _freeSlots.size() * 4 > _size;
+}
+
+/*
+ * Move all live agents to the front, optionally ordered by the Morton key
+ * of their grid cell so that agents close in space are also close together
+ * in the list.
+ */
+void AgentContainer::compact(bool spatialOrder) {
+	unsigned long live = 0;
+
+	if (spatialOrder) {
+		std::vector<std::pair<unsigned long long, Agent*> > order;
+		order.reserve(getCount());
+		for (unsigned long i = 0; i != _size; ++i) {
+			Agent* agent = (*this)[i];
+			if (agent == NULL)
+				continue;
+			intVector3d cell = agent->getGridPos();
+			order.push_back(
+					std::make_pair(mortonKey(cell.x, cell.y, cell.z), agent));
+		}
+		std::stable_sort(order.begin(), order.end(), mortonOrder);
+		for (; live != order.size(); ++live)
+			place(live, order[live].second);
+	} else {
+		for (unsigned long i = 0; i != _size; ++i) {
+			Agent* agent = (*this)[i];
+			if (agent != NULL)
+				place(live++, agent);
+		}
+	}
+
+	_size = live;
+	_freeSlots.clear();
+	releaseChunks((_size + kAgentChunkMask) >> kAgentChunkShift);
+}
+
+} /* namespace BNSim */
@@ -0,0 +1,146 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "agentStore.h"
+#include "mutexlock.h"
+#include <stdlib.h>
+#include <new>
+
+namespace BNSim {
+
+AgentStore::AgentStore() :
+		_blockCount(0), _highWater(0), _reordered(false) {
+	// the block table is allocated once so that readers never see it move
+	_blocks = new AgentBlock*[kMaxAgentBlocks];
+	for (unsigned int i = 0; i != kMaxAgentBlocks; ++i)
+		_blocks[i] = NULL;
+}
+
+AgentStore::~AgentStore() {
+	for (unsigned int i = 0; i != _blockCount; ++i)
+		free(_blocks[i]);
+	delete[] _blocks;
+}
+
+void AgentStore::addBlock() {
+	void* mem = NULL;
+	if (_blockCount == kMaxAgentBlocks
+			|| posix_memalign(&mem, 64, sizeof(AgentBlock)) != 0)
+		throw std::bad_alloc();
+
+	AgentBlock* block = (AgentBlock*) mem;
+	for (unsigned int i = 0; i != kAgentBlockSize; ++i)
+		block->owner[i] = NULL;
+
+	_blocks[_blockCount++] = block;
+}
+
+agentHandle AgentStore::acquire(Agent* owner) {
+	mutexLock lock(locker);
+
+	agentHandle h;
+	if (!_freeList.empty()) {
+		h = _freeList.back();
+		_freeList.pop_back();
+	} else {
+		if (_highWater == _blockCount * kAgentBlockSize)
+			addBlock();
+		h = _highWater++;
+		// a new handle starts out in the row of the same number
+		_blocks[h >> kAgentBlockShift]->row[h & kAgentBlockMask] = h;
+		_blocks[h >> kAgentBlockShift]->handle[h & kAgentBlockMask] = h;
+	}
+
+	posX(h) = posY(h) = posZ(h) = 0;
+	deltaX(h) = deltaY(h) = deltaZ(h) = 0;
+	totalRadius(h) = cellRadius(h) = shovek(h) = 0;
+	mobility(h) = 1;
+	idleSteps(h) = 0;
+	gridCell(h) = 0;
+	type(h) = genericAgent;
+	this->owner(h) = owner;
+
+	return h;
+}
+
+void AgentStore::release(agentHandle h) {
+	mutexLock lock(locker);
+
+	owner(h) = NULL;
+	_freeList.push_back(h);
+}
+
+// move row from[r] to row r in one column
+template<typename T>
+void AgentStore::permute(T (AgentBlock::*column)[kAgentBlockSize],
+		const std::vector<agentHandle>& from) {
+	std::vector<T> buffer(from.size());
+	for (std::size_t r = 0; r != from.size(); ++r)
+		buffer[r] = (_blocks[from[r] >> kAgentBlockShift]->*column)[from[r]
+				& kAgentBlockMask];
+	for (std::size_t r = 0; r != from.size(); ++r)
+		(_blocks[r >> kAgentBlockShift]->*column)[r & kAgentBlockMask] =
+				buffer[r];
+}
+
+/*
+ * Give the listed handles rows 0 .. n-1 in the order given, the free
+ * handles keep the remaining rows. Only valid between steps, while no
+ * other thread touches the store.
+ */
+void AgentStore::reorder(const agentHandle* handles, unsigned long n) {
+	mutexLock lock(locker);
+	_reordered = true;
+
+	std::vector<agentHandle> from;
+	std::vector<bool> taken(_highWater, false);
+	from.reserve(_highWater);
+	for (unsigned long i = 0; i != n; ++i) {
+		agentHandle r = row(handles[i]);
+		from.push_back(r);
+		taken[r] = true;
+	}
+	for (agentHandle r = 0; r != _highWater; ++r)
+		if (!taken[r])
+			from.push_back(r);
+
+	permute(&AgentBlock::x, from);
+	permute(&AgentBlock::y, from);
+	permute(&AgentBlock::z, from);
+	permute(&AgentBlock::dx, from);
+	permute(&AgentBlock::dy, from);
+	permute(&AgentBlock::dz, from);
+	permute(&AgentBlock::totalRadius, from);
+	permute(&AgentBlock::cellRadius, from);
+	permute(&AgentBlock::shovek, from);
+	permute(&AgentBlock::mobility, from);
+	permute(&AgentBlock::idleSteps, from);
+	permute(&AgentBlock::gridCell, from);
+	permute(&AgentBlock::type, from);
+	permute(&AgentBlock::owner, from);
+	permute(&AgentBlock::handle, from);
+
+	for (agentHandle r = 0; r != _highWater; ++r) {
+		agentHandle h = handleAt(r);
+		_blocks[h >> kAgentBlockShift]->row[h & kAgentBlockMask] = r;
+	}
+}
+
+} /* namespace BNSim */
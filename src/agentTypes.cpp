@@ -0,0 +1,53 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "agentTypes.h"
+#include "agent.h"
+#include "mutexlock.h"
+
+namespace BNSim {
+
+static void virtualUpdateKernel(Agent** agents, unsigned long n) {
+	for (unsigned long i = 0; i != n; ++i)
+		agents[i]->update();
+}
+
+AgentTypeRegistry::typeRecord AgentTypeRegistry::types[kMaxAgentTypes] = { {
+		&typeid(Agent), &virtualUpdateKernel } };
+unsigned int AgentTypeRegistry::typeCount = 1;
+std::mutex AgentTypeRegistry::locker;
+
+unsigned int AgentTypeRegistry::add(const std::type_info& info,
+		agentKernel kernel) {
+	mutexLock lock(locker);
+
+	for (unsigned int i = 0; i != typeCount; ++i)
+		if (*types[i].info == info)
+			return i;
+
+	if (typeCount == kMaxAgentTypes)
+		return 0;   // table full, fall back to virtual dispatch
+
+	types[typeCount].info = &info;
+	types[typeCount].kernel = kernel;
+	return typeCount++;
+}
+
+} /* namespace BNSim */
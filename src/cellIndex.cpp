@@ -0,0 +1,147 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "cellIndex.h"
+#include <pthread.h>
+
+namespace BNSim {
+
+CellIndex::CellIndex() :
+		_cellCount(0), _fill(NULL), _fillSize(0), _keys(NULL), _source(NULL) {
+}
+
+CellIndex::~CellIndex() {
+	delete[] _fill;
+}
+
+void CellIndex::run(void* (*fn)(void*), std::vector<task_t>& tasks) {
+	std::vector<pthread_t> thr(tasks.size());
+
+	for (std::size_t i = 0; i != tasks.size(); ++i) {
+		if (pthread_create(&thr[i], NULL, fn, &tasks[i])) {
+			// could not spawn, do the remaining work on this thread
+			for (std::size_t j = i; j != tasks.size(); ++j)
+				fn(&tasks[j]);
+			tasks.resize(i);
+			break;
+		}
+	}
+	for (std::size_t i = 0; i != tasks.size(); ++i)
+		pthread_join(thr[i], NULL);
+}
+
+// count the items of every cell
+void* CellIndex::count_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	CellIndex* index = task->index;
+
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		unsigned int key = index->_keys[i];
+		if (key != noCell)
+			index->_fill[key].fetch_add(1, std::memory_order_relaxed);
+	}
+	return NULL;
+}
+
+// total of a slice of cells
+void* CellIndex::sum_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	CellIndex* index = task->index;
+
+	unsigned int sum = 0;
+	for (unsigned int c = task->cellBegin; c != task->cellEnd; ++c)
+		sum += index->_fill[c].load(std::memory_order_relaxed);
+	task->sum = sum;
+	return NULL;
+}
+
+// exclusive scan of a slice of cells, offset by the sum of earlier slices
+void* CellIndex::scan_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	CellIndex* index = task->index;
+
+	unsigned int running = task->sum;
+	for (unsigned int c = task->cellBegin; c != task->cellEnd; ++c) {
+		unsigned int n = index->_fill[c].load(std::memory_order_relaxed);
+		index->_start[c] = running;
+		index->_fill[c].store(running, std::memory_order_relaxed);
+		running += n;
+	}
+	return NULL;
+}
+
+void* CellIndex::scatter_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	CellIndex* index = task->index;
+
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		unsigned int key = index->_keys[i];
+		if (key != noCell)
+			index->_items[index->_fill[key].fetch_add(1,
+					std::memory_order_relaxed)] = index->_source[i];
+	}
+	return NULL;
+}
+
+void CellIndex::build(unsigned int cellCount, const unsigned int* keys,
+		const agentHandle* items, unsigned long n, unsigned int threads) {
+	if (threads == 0)
+		threads = 1;
+
+	if (_fillSize < cellCount) {
+		delete[] _fill;
+		_fill = new std::atomic<unsigned int>[cellCount];
+		_fillSize = cellCount;
+	}
+	for (unsigned int c = 0; c != cellCount; ++c)
+		_fill[c].store(0, std::memory_order_relaxed);
+
+	_cellCount = cellCount;
+	_start.resize(cellCount + 1);
+	_keys = keys;
+	_source = items;
+
+	std::vector<task_t> tasks(threads);
+	for (unsigned int t = 0; t != threads; ++t) {
+		tasks[t].index = this;
+		tasks[t].begin = n * t / threads;
+		tasks[t].end = n * (t + 1) / threads;
+		tasks[t].cellBegin = (unsigned long) cellCount * t / threads;
+		tasks[t].cellEnd = (unsigned long) cellCount * (t + 1) / threads;
+	}
+
+	run(count_thread, tasks);
+
+	// slice sums, then the slices scan in parallel from their offsets
+	run(sum_thread, tasks);
+	unsigned int total = 0;
+	for (unsigned int t = 0; t != threads; ++t) {
+		unsigned int sum = tasks[t].sum;
+		tasks[t].sum = total;
+		total += sum;
+	}
+	run(scan_thread, tasks);
+	_start[cellCount] = total;
+
+	_items.resize(total > 0 ? total : 1);
+	run(scatter_thread, tasks);
+}
+
+} /* namespace BNSim */
@@ -19,37 +19,166 @@
  */
 
 #include "regulatoryNet.h"
+#include "randomStream.h"
+#include "inverseCDF.h"
+#include "fastMath.h"
+#include "mutexlock.h"
+#include <map>
+#include <mutex>
 
 namespace BNSim {
 
-ChemotaxisSystem::ChemotaxisSystem(Agent * host) :
-		RegulatoryNet(host) {
-	CCW = false;
-	Y = 0;
+const double kRotationalDiffusion = 0.28;  // rad^2/s
+const unsigned long kChemotaxisChunk = 256;
+const unsigned int kMotorRateSize = 4096;  // intervals of the kPlus/kMinus table
+
+// tumble angles in degrees: gamma(shape 4, scale 18.32) shifted by -4.60
+const double kTumbleShape = 4;
+const double kTumbleScale = 18.32;
+const double kTumbleLocation = -4.60;
+
+static double tumbleDensity(double angle) {
+	double x = (angle - kTumbleLocation) / kTumbleScale;
+	return pow(x, kTumbleShape - 1) * exp(-x);
+}
+
+// angles above 180 degrees were rejected, so the table stops there
+static const InverseCDF& tumbleAngles() {
+	static const InverseCDF table(&tumbleDensity, kTumbleLocation, 180);
+	return table;
+}
+
+/*
+ * State of a chunk of networks in structure-of-arrays form, so that each
+ * stage of the batch update is one loop over plain columns.
+ */
+struct chemotaxisColumns {
+	double aspcon[kChemotaxisChunk];
+	double m[kChemotaxisChunk];
+	double activity[kChemotaxisChunk];
+	double Y[kChemotaxisChunk];
+	double kPlus[kChemotaxisChunk], kMinus[kChemotaxisChunk];
+	double ccw[kChemotaxisChunk];
+	double clock[kChemotaxisChunk];
+	double x[kChemotaxisChunk], y[kChemotaxisChunk], z[kChemotaxisChunk];
+	double angle[kChemotaxisChunk];
+	// switch draw, angle draw and a random vector per network
+	double u[5 * kChemotaxisChunk];
+};
+
+/*
+ * kPlus and kMinus as functions of Y on [0, Ya], for linear interpolation.
+ * With the default parameters the interpolation error is below 1e-5
+ * relative. There is one table per parameter block, shared by all threads;
+ * it is rebuilt when the block's values no longer match the table, which
+ * must not happen in the middle of a step.
+ */
+struct motorRateTable {
+	motorRateTable() : Ya(-1), Kd(-1), g0(0), g1(0), w(0), scale(0) {}
+	bool matches(const ChemotaxisParams& p) const {
+		return p.Ya == Ya && p.Kd == Kd && p.g0 == g0 && p.g1 == g1
+				&& p.w == w;
+	}
+	void build(const ChemotaxisParams& p) {
+		Ya = p.Ya;
+		Kd = p.Kd;
+		g0 = p.g0;
+		g1 = p.g1;
+		w = p.w;
+		scale = Ya > 0 ? kMotorRateSize / Ya : 0;
+		for (unsigned int i = 0; i <= kMotorRateSize; ++i) {
+			double Y = i / scale;
+			double bound = Y / (Kd + Y);
+			plus[i] = w * exp(g0 / 4.0 - g0 / 2.0 * bound);
+			minus[i] = w * exp(-g1 / 4.0 + g1 / 2.0 * bound);
+		}
+	}
+	void lookup(const double* Y, double* kPlus, double* kMinus,
+			unsigned long n) const {
+		for (unsigned long k = 0; k != n; ++k) {
+			double position = Y[k] * scale;
+			position = position < 0 ? 0 : (position > kMotorRateSize ?
+					kMotorRateSize : position);
+			unsigned int i = (unsigned int) position;
+			i = i == kMotorRateSize ? i - 1 : i;
+			double fraction = position - i;
+			kPlus[k] = plus[i] + fraction * (plus[i + 1] - plus[i]);
+			kMinus[k] = minus[i] + fraction * (minus[i + 1] - minus[i]);
+		}
+	}
+	double Ya, Kd, g0, g1, w;   // parameters the table was built from
+	double scale;
+	double plus[kMotorRateSize + 1], minus[kMotorRateSize + 1];
+};
+
+static const motorRateTable& motorRates(const ChemotaxisParams& p) {
+	static std::mutex locker;
+	static std::map<const ChemotaxisParams*, motorRateTable> tables;
+	mutexLock lock(locker);
+	motorRateTable& table = tables[&p];
+	if (!table.matches(p))
+		table.build(p);
+	return table;
+}
+
+// methylation, receptor activity and CheY-P of a chunk, exp and log from Math
+template<typename Math>
+static void receptorKernel(chemotaxisColumns& c, const ChemotaxisParams& p,
+		unsigned long count, double dt) {
+	for (unsigned long k = 0; k != count; ++k) {
+		double a = c.activity[k];
+		c.m[k] += dt * (p.kr * dt * (1 - a) - p.kb * dt * a);
+		double fm = p.alpha * (p.m0 - c.m[k]);
+		double epsilon = fm - Math::log((1 + c.aspcon[k] / p.KA)
+				/ (1 + c.aspcon[k] / p.KI));
+		c.activity[k] = 1 / (1 + Math::exp(p.N_tar * epsilon));
+		c.Y[k] = p.Ya * c.activity[k];
+	}
+}
+
+ChemotaxisParams::ChemotaxisParams() {
 	Ya = 5;
 	Ye = 3; //um
 	H = 10;
 	inverseTau = 5;
 	kr = 0.2;
 	kb = 0.2;
-	m = 2;
 	m0 = 1;
 	alpha = 1.7;
 	N_tar = 6;
-	aspcon = 0;
-	activity = 0.5;
 	KA = 3;
 	KI = 0.0182;
 	Kd = 3.06;
 	g0 = 40;
 	g1 = 40;
 	w = 1.3;
+}
+
+const ChemotaxisParams& ChemotaxisParams::defaults() {
+	static const ChemotaxisParams params;
+	return params;
+}
+
+ChemotaxisSystem::ChemotaxisSystem(Agent * host,
+		const ChemotaxisParams* params) :
+		RegulatoryNet(host), _params(params) {
+	CCW = false;
+	Y = 0;
+	m = 2;
+	aspcon = 0;
+	activity = 0.5;
 	tau = 0;
 	runtime = 0;
 	tumbletime = 1;
+	switchClock = -log(1 - RandomStream::local().next());
     myVector3d random(0.5-randomUniform(),0.5-randomUniform(),0.5-randomUniform());
             random.normalize();
     direction = random;
+    Aspartate = -1;
+}
+
+void ChemotaxisSystem::bindSpecies() {
+	Aspartate = CONFIG::universe->getMoleculeIndex("Aspartate");
 }
 
 double ChemotaxisSystem::randomUniform() {
@@ -60,12 +189,6 @@ void ChemotaxisSystem::update() {
 
 	// Read chemoattract concentration from environment
 
-	int Aspartate = -1;
-	Aspartate =
-			CONFIG::universe->getMoleculeInfo("Aspartate") == NULL ?
-					-1 :
-					CONFIG::universe->getMoleculeInfo("Aspartate")->getIndex();
-
 	intVector3d GPos = getHost()->getGridPos();
 	Grid* myGrid = CONFIG::universe->getGrid(GPos.x, GPos.y, GPos.z);
 
@@ -74,14 +197,19 @@ void ChemotaxisSystem::update() {
 
 	m = m
 			+ CONFIG::timestep
-					* (kr * CONFIG::timestep * (1 - activity)
-							- kb * CONFIG::timestep * activity);
+					* (_params->kr * CONFIG::timestep * (1 - activity)
+							- _params->kb * CONFIG::timestep * activity);
 
-	double fm = alpha * (m0 - m);
-	double epsilon = fm - log((1 + aspcon / KA) / (1 + aspcon / KI));
-	activity = 1 / (1 + exp(N_tar * epsilon));
+	double fm = _params->alpha * (_params->m0 - m);
+	double epsilon = fm - log((1 + aspcon / _params->KA) / (1 + aspcon / _params->KI));
+	activity = 1 / (1 + exp(_params->N_tar * epsilon));
 
-	Y = Ya * activity;
+	Y = _params->Ya * activity;
+
+	if (CONFIG::eventMotor) {
+		eventStep(kPlus(), kMinus(), CONFIG::timestep, RandomStream::local());
+		return;
+	}
 
 	if (CCW && randomUniform() < kMinus()) {
 		CCW = false;
@@ -95,28 +223,176 @@ void ChemotaxisSystem::update() {
         rotationalDiffusion();
 }
 
+/*
+ * Batch form of update(). Networks are taken in chunks that share one
+ * parameter block: their state is gathered into columns, methylation,
+ * activity, motor switching and reorientation run as loops over the
+ * columns, and the state is scattered back. Random numbers come in bulk
+ * from the thread's RandomStream.
+ */
+void ChemotaxisSystem::updateBatch(ChemotaxisSystem** nets, unsigned long n) {
+	static thread_local chemotaxisColumns c;
+	RandomStream& random = RandomStream::local();
+	double dt = CONFIG::timestep;
+	double diffusion = sqrt(2 * kRotationalDiffusion * dt);
+	const InverseCDF& tumbles = tumbleAngles();
+
+	unsigned long end;
+	for (unsigned long begin = 0; begin < n; begin = end) {
+		const ChemotaxisParams& p = *nets[begin]->_params;
+		end = begin + 1;
+		while (end != n && end - begin != kChemotaxisChunk
+				&& nets[end]->_params == &p)
+			++end;
+		ChemotaxisSystem** chunk = nets + begin;
+		unsigned long count = end - begin;
+
+		for (unsigned long k = 0; k != count; ++k) {
+			ChemotaxisSystem* net = chunk[k];
+			if (net->Aspartate != -1) {
+				intVector3d GPos = net->getHost()->getGridPos();
+				net->aspcon = CONFIG::universe->getGrid(GPos.x, GPos.y,
+						GPos.z)->getConc(net->Aspartate);
+			}
+			c.aspcon[k] = net->aspcon;
+			c.m[k] = net->m;
+			c.activity[k] = net->activity;
+			c.ccw[k] = net->CCW;
+			c.clock[k] = net->switchClock;
+			c.x[k] = net->direction.pos.x;
+			c.y[k] = net->direction.pos.y;
+			c.z[k] = net->direction.pos.z;
+		}
+		random.fill(c.u, 5 * count);
+
+		// receptor activity and motor rates, see CONFIG::fastChemotaxisMath
+		if (CONFIG::fastChemotaxisMath) {
+			receptorKernel<FastMath>(c, p, count, dt);
+			motorRates(p).lookup(c.Y, c.kPlus, c.kMinus, count);
+		} else {
+			receptorKernel<ExactMath>(c, p, count, dt);
+			for (unsigned long k = 0; k != count; ++k) {
+				double bound = c.Y[k] / (p.Kd + c.Y[k]);
+				c.kPlus[k] = p.w * exp(p.g0 / 4.0 - p.g0 / 2.0 * bound);
+				c.kMinus[k] = p.w * exp(-p.g1 / 4.0 + p.g1 / 2.0 * bound);
+			}
+		}
+
+		// the event-driven motor moves each network through its own events
+		if (CONFIG::eventMotor) {
+			for (unsigned long k = 0; k != count; ++k) {
+				ChemotaxisSystem* net = chunk[k];
+				net->eventStep(c.kPlus[k], c.kMinus[k], dt, random);
+				c.ccw[k] = net->CCW;
+				c.clock[k] = net->switchClock;
+				c.x[k] = net->direction.pos.x;
+				c.y[k] = net->direction.pos.y;
+				c.z[k] = net->direction.pos.z;
+			}
+		} else {
+			// motor switching, CCW to CW at kMinus and CW to CCW at kPlus
+			for (unsigned long k = 0; k != count; ++k) {
+				double rate = c.ccw[k] * c.kMinus[k]
+						+ (1 - c.ccw[k]) * c.kPlus[k];
+				c.ccw[k] = c.u[k] < rate ? 1 - c.ccw[k] : c.ccw[k];
+			}
+
+			// tumble while CW, rotational diffusion while CCW
+			for (unsigned long k = 0; k != count; ++k)
+				c.angle[k] = c.ccw[k] != 0 ? c.u[count + k] * diffusion :
+						tumbles.sample(c.u[count + k]) * 3.14 / 360.0;
+
+			// rotate about a random axis perpendicular to the direction
+			for (unsigned long k = 0; k != count; ++k) {
+				const double* r = &c.u[2 * count + 3 * k];
+				rotatePerpendicular(c.x[k], c.y[k], c.z[k], c.angle[k],
+						0.5 - r[0], 0.5 - r[1], 0.5 - r[2]);
+			}
+		}
+
+		for (unsigned long k = 0; k != count; ++k) {
+			ChemotaxisSystem* net = chunk[k];
+			net->m = c.m[k];
+			net->activity = c.activity[k];
+			net->Y = c.Y[k];
+			net->CCW = c.ccw[k] != 0;
+			net->switchClock = c.clock[k];
+			net->direction.pos.x = c.x[k];
+			net->direction.pos.y = c.y[k];
+			net->direction.pos.z = c.z[k];
+		}
+	}
+}
+
 /*
  Sneddon, Michael W., William Pontius, and Thierry Emonet. "Stochastic coordination of multiple actuators reduces latency and improves chemotactic response in bacteria." Proceedings of the National Academy of Sciences 109.3 (2012): 805-810.
  */
 
 // rate from CW to CCW
 double ChemotaxisSystem::kPlus() {
-	double r = w * exp((g0 / 4.0) - (g0 / 2.0) * (Y / (Kd + Y)));
+	double r = _params->w * exp((_params->g0 / 4.0) - (_params->g0 / 2.0) * (Y / (_params->Kd + Y)));
 	return r;
 }
 
 // rate from CCW to CW
 double ChemotaxisSystem::kMinus() {
-	double r = w * exp(-(g1 / 4.0) + (g1 / 2.0) * (Y / (Kd + Y)));
+	double r = _params->w * exp(-(_params->g1 / 4.0) + (_params->g1 / 2.0) * (Y / (_params->Kd + Y)));
 	return r;
 }
 
+/*
+ * Event-driven motor: switchClock is the integrated hazard left until the
+ * next switch, an Exp(1) draw. The step uses it up at the rate of the
+ * current motor state; whenever it runs out the motor switches and a new
+ * clock is drawn. Every CCW to CW switch is one tumble, and the runs in
+ * between are swum straight, diffusing over their own duration only. travel
+ * receives the path of the step in units of velocity * dt, i.e. the sum of
+ * the run segments along the direction each was swum in. This holds for
+ * any timestep as long as the rates stay constant over the step.
+ *
+ * It is a different model from the per-step path of update(), which takes
+ * kPlus and kMinus as switch probabilities per step, tumbles on every CW
+ * step and keeps swimming while CW. The two only agree in the switching
+ * frequency for a timestep of 1 s.
+ */
+void ChemotaxisSystem::eventStep(double kPlus, double kMinus, double dt,
+		RandomStream& random) {
+	travel = myVector3d(0, 0, 0);
+	double left = dt;
+	for (;;) {
+		double rate = CCW ? kMinus : kPlus;
+		bool switches = switchClock < rate * left;
+		double span = switches ? switchClock / rate : left;
+		if (CCW && span > 0) {
+			travel.pos.x += direction.pos.x * span / dt;
+			travel.pos.y += direction.pos.y * span / dt;
+			travel.pos.z += direction.pos.z * span / dt;
+			myVector3d axis(0.5 - random.next(), 0.5 - random.next(),
+					0.5 - random.next());
+			direction.rotatePerp(
+					random.next() * sqrt(2 * kRotationalDiffusion * span), axis);
+		}
+		if (!switches) {
+			switchClock -= rate * left;
+			return;
+		}
+		left -= span;
+		CCW = !CCW;
+		switchClock = -log(1 - random.next());
+		if (!CCW) {
+			myVector3d axis(0.5 - random.next(), 0.5 - random.next(),
+					0.5 - random.next());
+			direction.rotatePerp(
+					tumbleAngles().sample(random.next()) * 3.14 / 360.0, axis);
+		}
+	}
+}
+
 /**
  * Causes the cell to rotate such that Var(theta(dt)) = 4*D*dt.
  */
 void ChemotaxisSystem::rotationalDiffusion() {
-	double Dr = 0.28;  // rotational diffusion constant rad^2/s
-	double dTheta = randomUniform()*sqrt(2*Dr*CONFIG::timestep);
+	double dTheta = randomUniform()*sqrt(2*kRotationalDiffusion*CONFIG::timestep);
 	rotatePerp(direction, dTheta);
 }
 
@@ -124,88 +400,24 @@ void ChemotaxisSystem::rotationalDiffusion() {
  * Return a tumble angle in radians distributed according to Fig. 3, 'Chemotaxis
  * in Escherichia Coli', Berg et al. (claim from 'AgentCell: a digital single-cell
  * assay for bacterial chemotaxis', Emonet et al.).
+ * Drawn from a tabulated inverse CDF with a single uniform number.
  */
 double ChemotaxisSystem::tumbleAngle() {
-	double tumbleShape = 4;
-	double tumbleScale = 18.32;
-	double tumbleLocation = -4.60;
-
-	double tumbleAngle;
-	do {
-		tumbleAngle = sampleGamma(tumbleShape, tumbleScale) + tumbleLocation;
-	} while (tumbleAngle > 180);
-
-	return (tumbleAngle*3.14/360.0);
+	return tumbleAngles().sample(randomUniform()) * 3.14 / 360.0;
 }
 
 void ChemotaxisSystem::tumble() {
 	rotatePerp(direction, tumbleAngle());
 }
 
-double ChemotaxisSystem::sampleGamma(double k, double theta) {
-	bool accept = false;
-	if (k < 1) {
-		// Weibull algorithm
-		double c = (1 / k);
-		double d = ((1 - k) * pow(k, (k / (1 - k))));
-		double u, v, z, e, x;
-		do {
-			u = randomUniform();	v = randomUniform();
-			z = -log(u);		e = -log(v);
-			x = pow(z, c);
-			if ((z + e) >= (d + x)) {
-				accept = true;
-			}
-		} while (!accept);
-		return (x * theta);
-	} else {
-		// Cheng's algorithm
-		double b = (k - log(4));
-		double c = (k + sqrt(2 * k - 1));
-		double lam = sqrt(2 * k - 1);
-		double cheng = (1 + log(4.5));
-		double u, v, x, y, z, r;
-		do {
-			u = randomUniform();		v = randomUniform();
-			y = ((1 / lam) * log(v / (1 - v)));
-			x = (k * exp(y));
-			z = (u * v * v);
-			r = (b + (c * y) - x);
-			if ((r >= ((4.5 * z) - cheng)) ||
-					(r >= log(z))) {
-				accept = true;
-			}
-		} while (!accept);
-		return (x * theta);
-	}
-}
-
 /**
  * Rotates the vector v by an angle theta in a random direction perpendicular to v.
  * From BSim, Gorochowski, Thomas E., et al. "BSim: an agent-based tool for modeling
  * bacterial populations in systems and synthetic biology." PloS one 7.8 (2012): e42790.
  */
 void ChemotaxisSystem::rotatePerp(myVector3d& v, double theta) {
-	/* Obtain a random direction perpendicular to v */
 	myVector3d random(0.5-randomUniform(),0.5-randomUniform(),0.5-randomUniform());
-	myVector3d randomPerp;
-	randomPerp.cross(v, random);
-	rotate(v, randomPerp, theta);
-	// Ensure the vector is unit
-	v.normalize();
-}
-
-/**
- * Rotates the vector v towards the specified axis by an angle theta.
- * From BSim, Gorochowski, Thomas E., et al. "BSim: an agent-based tool for modeling
- * bacterial populations in systems and synthetic biology." PloS one 7.8 (2012): e42790.
- */
-void ChemotaxisSystem::rotate(myVector3d& v, myVector3d axis, double theta) {
-	/* Generate the rotation matrix for rotating about the axis by an angle theta */
-	myMatrix3d  r;
-	r.setFromAxisAngle(axis.pos.x, axis.pos.y, axis.pos.z, theta);
-	/* Apply the rotation */
-	r.transform(v);
+	v.rotatePerp(theta, random);
 }
 
 } /* namespace BNSim */
@@ -0,0 +1,86 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "componentRegistry.h"
+#include "regulatoryNet.h"
+#include "mutexlock.h"
+#include <algorithm>
+
+namespace BNSim {
+
+ComponentRegistry::componentRecord ComponentRegistry::components[kMaxComponentTypes];
+unsigned int ComponentRegistry::typeCount = 0;
+std::mutex ComponentRegistry::locker;
+
+unsigned int ComponentRegistry::add(const std::type_info& info,
+		unsigned int width) {
+	mutexLock lock(locker);
+
+	for (unsigned int i = 0; i != typeCount; ++i)
+		if (*components[i].info == info)
+			return i;
+
+	if (typeCount == kMaxComponentTypes)
+		return invalidComponent;
+
+	components[typeCount].info = &info;
+	components[typeCount].width = width;
+	return typeCount++;
+}
+
+void ComponentRegistry::bind(RegulatoryNet* net, unsigned int id) {
+	net->_componentType = id;
+}
+
+void ComponentRegistry::attach(RegulatoryNet* net) {
+	if (net->_componentType == invalidComponent
+			|| net->_denseIndex != notAttached)
+		return;
+
+	componentRecord& record = components[net->_componentType];
+	mutexLock lock(record.locker);
+	net->_denseIndex = record.dense.size();
+	record.dense.push_back(net);
+	record.state.resize(record.state.size() + record.width, 0.0);
+	// still under the lock, another attach may move the state array
+	net->publishState();
+}
+
+/*
+ * The last network of the arrays takes the place of the leaving one.
+ */
+
+void ComponentRegistry::detach(RegulatoryNet* net) {
+	if (net->_denseIndex == notAttached)
+		return;
+
+	componentRecord& record = components[net->_componentType];
+	mutexLock lock(record.locker);
+	RegulatoryNet* last = record.dense.back();
+	record.dense[net->_denseIndex] = last;
+	std::copy(record.state.end() - record.width, record.state.end(),
+			record.state.begin() + net->_denseIndex * record.width);
+	last->_denseIndex = net->_denseIndex;
+	record.dense.pop_back();
+	record.state.resize(record.state.size() - record.width);
+	net->_denseIndex = notAttached;
+}
+
+} /* namespace BNSim */
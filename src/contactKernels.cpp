@@ -0,0 +1,242 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "contactKernels.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BNSIM_AVX2_KERNEL
+#endif
+
+namespace BNSim {
+
+/*
+ * Each pair in contact is pushed apart along the line of centers, both
+ * sides by half of the overlap; agents that are not mobile stay put, and
+ * pairs where neither agent is mobile are skipped.
+ */
+double scalarContactKernel(const contactBlock& block, unsigned long begin,
+		unsigned long end) {
+	const double* x = block.x;
+	const double* y = block.y;
+	const double* z = block.z;
+	const double* radius = block.radius;
+	const double* mobility = block.mobility;
+	double* delta = block.delta;
+	double maxOverlap = 0;
+
+	for (unsigned long i = begin; i != end; ++i) {
+		double dxi = 0, dyi = 0, dzi = 0, oi = 0;
+		for (unsigned long k = block.listStart[i]; k != block.listStart[i + 1];
+				++k) {
+			unsigned int j = block.neighbors[k];
+			if (mobility[i] + mobility[j] == 0)
+				continue;
+			double dx = x[i] - x[j];
+			double dy = y[i] - y[j];
+			double dz = z[i] - z[j];
+			double radiusSum = radius[i] + radius[j];
+			double distance2 = dx * dx + dy * dy + dz * dz;
+
+			// packed
+			if (distance2 >= radiusSum * radiusSum || distance2 == 0)
+				continue;
+			double distance = sqrt(distance2);
+			double overlap = radiusSum - distance;
+			double push = 0.5 * overlap / distance;
+			maxOverlap = std::max(maxOverlap, overlap);
+
+			dxi += push * dx;
+			dyi += push * dy;
+			dzi += push * dz;
+			oi += overlap;
+			delta[4 * j] -= mobility[j] * push * dx;
+			delta[4 * j + 1] -= mobility[j] * push * dy;
+			delta[4 * j + 2] -= mobility[j] * push * dz;
+			delta[4 * j + 3] += overlap;
+		}
+		delta[4 * i] += mobility[i] * dxi;
+		delta[4 * i + 1] += mobility[i] * dyi;
+		delta[4 * i + 2] += mobility[i] * dzi;
+		delta[4 * i + 3] += oi;
+	}
+	return maxOverlap;
+}
+
+#ifdef BNSIM_AVX2_KERNEL
+
+static inline double horizontalMax(__m256d v) __attribute__((target("avx2")));
+static inline double horizontalMax(__m256d v) {
+	__m128d low = _mm_max_pd(_mm256_castpd256_pd128(v),
+			_mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_max_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+static inline double horizontalSum(__m256d v) __attribute__((target("avx2")));
+static inline double horizontalSum(__m256d v) {
+	__m128d low = _mm256_castpd256_pd128(v);
+	__m128d high = _mm256_extractf128_pd(v, 1);
+	low = _mm_add_pd(low, high);
+	return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+/*
+ * Same contacts as the scalar kernel, four neighbors of an agent at a time:
+ * the neighbors' packed columns are gathered by index, overlaps of all four
+ * lanes are computed at once, and only lanes in contact are scattered back.
+ */
+__attribute__((target("avx2,fma")))
+static double avx2ContactKernel(const contactBlock& block, unsigned long begin,
+		unsigned long end) {
+	const double* x = block.x;
+	const double* y = block.y;
+	const double* z = block.z;
+	const double* radius = block.radius;
+	const double* mobility = block.mobility;
+	double* delta = block.delta;
+	const __m256d half = _mm256_set1_pd(0.5);
+	const __m256d zero = _mm256_setzero_pd();
+	__m256d overlaps = zero;
+	double maxOverlap = 0;
+
+	for (unsigned long i = begin; i != end; ++i) {
+		unsigned long k = block.listStart[i];
+		unsigned long last = block.listStart[i + 1];
+		__m256d xi = _mm256_set1_pd(x[i]);
+		__m256d yi = _mm256_set1_pd(y[i]);
+		__m256d zi = _mm256_set1_pd(z[i]);
+		__m256d ri = _mm256_set1_pd(radius[i]);
+		__m256d mi = _mm256_set1_pd(mobility[i]);
+		__m256d sumX = zero, sumY = zero, sumZ = zero, sumO = zero;
+
+		for (; k + 4 <= last; k += 4) {
+			__m128i j = _mm_loadu_si128((const __m128i*) (block.neighbors + k));
+			// pairs of two agents at rest have nothing to resolve
+			__m256d mj = _mm256_i32gather_pd(mobility, j, 8);
+			__m256d moving = _mm256_cmp_pd(_mm256_add_pd(mi, mj), zero,
+					_CMP_GT_OQ);
+			if (_mm256_movemask_pd(moving) == 0)
+				continue;
+
+			__m256d dx = _mm256_sub_pd(xi, _mm256_i32gather_pd(x, j, 8));
+			__m256d dy = _mm256_sub_pd(yi, _mm256_i32gather_pd(y, j, 8));
+			__m256d dz = _mm256_sub_pd(zi, _mm256_i32gather_pd(z, j, 8));
+			__m256d radiusSum = _mm256_add_pd(ri,
+					_mm256_i32gather_pd(radius, j, 8));
+			__m256d distance2 = _mm256_fmadd_pd(dx, dx,
+					_mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+
+			__m256d packed = _mm256_and_pd(moving, _mm256_and_pd(
+					_mm256_cmp_pd(distance2,
+							_mm256_mul_pd(radiusSum, radiusSum), _CMP_LT_OQ),
+					_mm256_cmp_pd(distance2, zero, _CMP_GT_OQ)));
+			int lanes = _mm256_movemask_pd(packed);
+			if (lanes == 0)
+				continue;
+
+			__m256d distance = _mm256_sqrt_pd(distance2);
+			__m256d overlap = _mm256_and_pd(packed,
+					_mm256_sub_pd(radiusSum, distance));
+			__m256d push = _mm256_and_pd(packed,
+					_mm256_div_pd(_mm256_mul_pd(half, overlap), distance));
+			overlaps = _mm256_max_pd(overlaps, overlap);
+			__m256d px = _mm256_mul_pd(push, dx);
+			__m256d py = _mm256_mul_pd(push, dy);
+			__m256d pz = _mm256_mul_pd(push, dz);
+			sumX = _mm256_add_pd(sumX, px);
+			sumY = _mm256_add_pd(sumY, py);
+			sumZ = _mm256_add_pd(sumZ, pz);
+			sumO = _mm256_add_pd(sumO, overlap);
+
+			double outX[4], outY[4], outZ[4], outO[4];
+			_mm256_storeu_pd(outX, _mm256_mul_pd(mj, px));
+			_mm256_storeu_pd(outY, _mm256_mul_pd(mj, py));
+			_mm256_storeu_pd(outZ, _mm256_mul_pd(mj, pz));
+			_mm256_storeu_pd(outO, overlap);
+			for (unsigned int lane = 0; lane != 4; ++lane) {
+				if (!(lanes & (1 << lane)))
+					continue;
+				unsigned int n = block.neighbors[k + lane];
+				delta[4 * n] -= outX[lane];
+				delta[4 * n + 1] -= outY[lane];
+				delta[4 * n + 2] -= outZ[lane];
+				delta[4 * n + 3] += outO[lane];
+			}
+		}
+
+		double dxi = horizontalSum(sumX);
+		double dyi = horizontalSum(sumY);
+		double dzi = horizontalSum(sumZ);
+		double oi = horizontalSum(sumO);
+
+		// remainder of the list
+		for (; k != last; ++k) {
+			unsigned int j = block.neighbors[k];
+			if (mobility[i] + mobility[j] == 0)
+				continue;
+			double dx = x[i] - x[j];
+			double dy = y[i] - y[j];
+			double dz = z[i] - z[j];
+			double radiusSum = radius[i] + radius[j];
+			double distance2 = dx * dx + dy * dy + dz * dz;
+
+			if (distance2 >= radiusSum * radiusSum || distance2 == 0)
+				continue;
+			double distance = sqrt(distance2);
+			double overlap = radiusSum - distance;
+			double push = 0.5 * overlap / distance;
+			maxOverlap = std::max(maxOverlap, overlap);
+
+			dxi += push * dx;
+			dyi += push * dy;
+			dzi += push * dz;
+			oi += overlap;
+			delta[4 * j] -= mobility[j] * push * dx;
+			delta[4 * j + 1] -= mobility[j] * push * dy;
+			delta[4 * j + 2] -= mobility[j] * push * dz;
+			delta[4 * j + 3] += overlap;
+		}
+		delta[4 * i] += mobility[i] * dxi;
+		delta[4 * i + 1] += mobility[i] * dyi;
+		delta[4 * i + 2] += mobility[i] * dzi;
+		delta[4 * i + 3] += oi;
+	}
+	return std::max(maxOverlap, horizontalMax(overlaps));
+}
+
+#endif
+
+static contactKernel selectContactKernel() {
+#ifdef BNSIM_AVX2_KERNEL
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return &avx2ContactKernel;
+#endif
+	return &scalarContactKernel;
+}
+
+contactKernel getContactKernel() {
+	static contactKernel kernel = selectContactKernel();
+	return kernel;
+}
+
+} /* namespace BNSim */
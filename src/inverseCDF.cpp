@@ -0,0 +1,64 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "inverseCDF.h"
+#include <algorithm>
+
+namespace BNSim {
+
+/*
+ * Integrate the density with the trapezoid rule on a grid 16 times finer
+ * than the table, then read off the points where the cumulative reaches
+ * i / size.
+ */
+InverseCDF::InverseCDF(double (*density)(double x), double lo, double hi,
+		unsigned int size) :
+		_quantile(size + 1), _scale(size) {
+	unsigned int steps = 16 * size;
+	double h = (hi - lo) / steps;
+	std::vector<double> cumulative(steps + 1);
+	cumulative[0] = 0;
+	double previous = density(lo);
+	for (unsigned int j = 1; j <= steps; ++j) {
+		double current = density(lo + j * h);
+		cumulative[j] = cumulative[j - 1] + 0.5 * h * (previous + current);
+		previous = current;
+	}
+
+	double total = cumulative[steps];
+	for (unsigned int i = 0; i <= size; ++i) {
+		double target = total * i / size;
+		unsigned int j = std::lower_bound(cumulative.begin(), cumulative.end(),
+				target) - cumulative.begin();
+		if (j == 0) {
+			_quantile[i] = lo;
+		} else if (j > steps) {
+			_quantile[i] = hi;
+		} else {
+			double span = cumulative[j] - cumulative[j - 1];
+			double fraction = span > 0 ? (target - cumulative[j - 1]) / span : 0;
+			_quantile[i] = lo + (j - 1 + fraction) * h;
+		}
+	}
+	// so that u == 1 still reads a valid pair
+	_quantile.push_back(hi);
+}
+
+} /* namespace BNSim */
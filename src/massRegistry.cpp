@@ -0,0 +1,55 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "massRegistry.h"
+#include "mutexlock.h"
+
+namespace BNSim {
+
+MassRegistry::slotRecord MassRegistry::slots[kMaxMassSlots] = { { "X", true }, {
+		"EPS", false } };
+unsigned int MassRegistry::slotCount = 2;
+std::mutex MassRegistry::locker;
+
+unsigned int MassRegistry::getSlot(const std::string& name, bool cellMass) {
+	mutexLock lock(locker);
+
+	for (unsigned int i = 0; i != slotCount; ++i)
+		if (slots[i].name == name)
+			return i;
+
+	if (slotCount == kMaxMassSlots)
+		return invalidMassSlot;
+
+	slots[slotCount].name = name;
+	slots[slotCount].cellMass = cellMass;
+	return slotCount++;
+}
+
+unsigned int MassRegistry::findSlot(const std::string& name) {
+	mutexLock lock(locker);
+
+	for (unsigned int i = 0; i != slotCount; ++i)
+		if (slots[i].name == name)
+			return i;
+	return invalidMassSlot;
+}
+
+} /* namespace BNSim */
@@ -0,0 +1,453 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "mechanics.h"
+#include "configuration.h"
+#include "contactKernels.h"
+#include <algorithm>
+#include <pthread.h>
+
+namespace BNSim {
+
+Mechanics::Mechanics(AgentStore& store, const FrozenStore& frozen) :
+		_store(store), _frozen(frozen), _skin(0), _binSize(1), _inverseBinSize(1), _bucketMask(
+				0), _useTree(false), _treeCost(0), _treeBuilds(0), _listBuilds(0), _sleeping(0), _sweeps(
+				0), _initialOverlap(0), _residualOverlap(0), _converged(true) {
+}
+
+void Mechanics::run(void* (*fn)(void*), std::vector<task_t>& tasks) {
+	std::vector<pthread_t> thr(tasks.size());
+
+	for (std::size_t i = 0; i != tasks.size(); ++i) {
+		if (pthread_create(&thr[i], NULL, fn, &tasks[i])) {
+			for (std::size_t j = i; j != tasks.size(); ++j)
+				fn(&tasks[j]);
+			for (std::size_t j = 0; j != i; ++j)
+				pthread_join(thr[j], NULL);
+			return;
+		}
+	}
+	for (std::size_t i = 0; i != tasks.size(); ++i)
+		pthread_join(thr[i], NULL);
+}
+
+// even split of the listed agents over the threads
+void Mechanics::split(std::vector<task_t>& tasks, unsigned int threads) {
+	unsigned long n = _handles.size();
+	tasks.resize(threads);
+	for (unsigned int t = 0; t != threads; ++t) {
+		tasks[t].mechanics = this;
+		tasks[t].index = t;
+		tasks[t].begin = n * t / threads;
+		tasks[t].end = n * (t + 1) / threads;
+	}
+}
+
+void Mechanics::refresh(const agentHandle* handles, unsigned long n,
+		unsigned int threads, bool populationChanged) {
+	if (threads == 0)
+		threads = 1;
+	if (populationChanged || _skin != CONFIG::verletSkin
+			|| _useTree != CONFIG::contactBVH || needsRebuild(threads))
+		buildLists(handles, n, threads, populationChanged);
+}
+
+// largest movement plus growth of an agent since the last build
+void* Mechanics::drift_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+	AgentStore& store = m->_store;
+
+	double drift = 0;
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		agentHandle h = m->_handles[i];
+		double dx = store.posX(h) - m->_refX[i];
+		double dy = store.posY(h) - m->_refY[i];
+		double dz = store.posZ(h) - m->_refZ[i];
+		double growth = store.totalRadius(h) - m->_refRadius[i];
+		drift = std::max(drift,
+				sqrt(dx * dx + dy * dy + dz * dz) + std::max(growth, 0.0));
+	}
+	task->drift = drift;
+	return NULL;
+}
+
+/*
+ * A pair can close in by at most twice the largest drift, so the lists
+ * stay complete while that is within the skin.
+ */
+bool Mechanics::needsRebuild(unsigned int threads) {
+	std::vector<task_t> tasks;
+	split(tasks, threads);
+	run(drift_thread, tasks);
+
+	double drift = 0;
+	for (unsigned int t = 0; t != threads; ++t)
+		drift = std::max(drift, tasks[t].drift);
+	return 2 * drift > _skin;
+}
+
+/*
+ * Size the bins to the largest interaction distance of the population and
+ * sort the agents into the hashed buckets, by compact index.
+ */
+void Mechanics::rebin(unsigned int threads) {
+	unsigned long n = _refX.size();
+	double maxRadius = 0;
+	for (unsigned long i = 0; i != n; ++i)
+		maxRadius = std::max(maxRadius, _refRadius[i]);
+	_binSize = 2 * maxRadius + _skin;
+	if (_binSize <= 0)
+		_binSize = 1;
+	_inverseBinSize = 1 / _binSize;
+
+	// about two buckets per agent keeps collisions rare
+	unsigned int buckets = 1024;
+	while (buckets < 2 * n && buckets < (1u << 30))
+		buckets <<= 1;
+	_bucketMask = buckets - 1;
+
+	_keys.resize(n);
+	_items.resize(n);
+	_binOf.resize(n);
+	for (unsigned long i = 0; i != n; ++i) {
+		binKey key = makeKey(binOf(_refX[i]), binOf(_refY[i]), binOf(_refZ[i]));
+		_binOf[i] = key;
+		_keys[i] = hash(key);
+		_items[i] = i;
+	}
+
+	_bins.build(buckets, n == 0 ? NULL : &_keys[0],
+			n == 0 ? NULL : &_items[0], n, threads);
+}
+
+/*
+ * Refit the tree to the reference positions, or rebuild it if the compact
+ * index changed or refitting doubled its cost. Every sphere is boxed with
+ * half the skin, so two boxes overlap for every pair within the cutoff.
+ */
+void Mechanics::updateTree(bool populationChanged) {
+	unsigned long n = _refX.size();
+	const double* x = n == 0 ? NULL : &_refX[0];
+	const double* y = n == 0 ? NULL : &_refY[0];
+	const double* z = n == 0 ? NULL : &_refZ[0];
+	const double* radius = n == 0 ? NULL : &_refRadius[0];
+
+	if (!populationChanged && _useTree && _tree.getItemCount() == n) {
+		_tree.refit(x, y, z, radius, _skin / 2);
+		if (_tree.getCost() <= 2 * _treeCost)
+			return;
+	}
+	_tree.build(x, y, z, radius, n, _skin / 2);
+	_treeCost = _tree.getCost();
+	_treeBuilds++;
+}
+
+// collect the half lists of a range of agents, later agents only
+void* Mechanics::list_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+	std::vector<unsigned int>& neighbors = task->neighbors;
+	neighbors.clear();
+
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		double x = m->_refX[i], y = m->_refY[i], z = m->_refZ[i];
+		double radius = m->_refRadius[i] + m->_skin;
+
+		m->_listStart[i] = neighbors.size();
+		auto consider = [&](unsigned int j) {
+			if (j <= i)
+				return;
+			double dx = x - m->_refX[j];
+			double dy = y - m->_refY[j];
+			double dz = z - m->_refZ[j];
+			double cutoff = radius + m->_refRadius[j];
+			if (dx * dx + dy * dy + dz * dz < cutoff * cutoff)
+				neighbors.push_back(j);
+		};
+
+		if (m->_useTree) {
+			double reach = m->_refRadius[i] + m->_skin / 2;
+			double lo[3] = { x - reach, y - reach, z - reach };
+			double hi[3] = { x + reach, y + reach, z + reach };
+			m->_tree.query(lo, hi, consider);
+		} else {
+			m->forEachCandidate(i, consider);
+		}
+	}
+	return NULL;
+}
+
+void Mechanics::buildLists(const agentHandle* handles, unsigned long n,
+		unsigned int threads, bool populationChanged) {
+	bool treeChanged = _useTree != CONFIG::contactBVH;
+	_skin = CONFIG::verletSkin;
+	_useTree = CONFIG::contactBVH;
+
+	_handles.assign(handles, handles + n);
+	std::size_t frozen = _frozen.getCount();
+	_refX.resize(n + frozen);
+	_refY.resize(n + frozen);
+	_refZ.resize(n + frozen);
+	_refRadius.resize(n + frozen);
+	for (unsigned long i = 0; i != n; ++i) {
+		agentHandle h = handles[i];
+		_refX[i] = _store.posX(h);
+		_refY[i] = _store.posY(h);
+		_refZ[i] = _store.posZ(h);
+		_refRadius[i] = _store.totalRadius(h);
+	}
+	if (frozen != 0) {
+		std::copy(_frozen.getX(), _frozen.getX() + frozen, _refX.begin() + n);
+		std::copy(_frozen.getY(), _frozen.getY() + frozen, _refY.begin() + n);
+		std::copy(_frozen.getZ(), _frozen.getZ() + frozen, _refZ.begin() + n);
+		std::copy(_frozen.getRadius(), _frozen.getRadius() + frozen,
+				_refRadius.begin() + n);
+	}
+
+	listFromReferences(threads, populationChanged || treeChanged);
+}
+
+// build the lists around the reference positions
+void Mechanics::listFromReferences(unsigned int threads,
+		bool populationChanged) {
+	unsigned long n = _handles.size();
+	if (_useTree) {
+		updateTree(populationChanged);
+	} else {
+		rebin(threads);
+	}
+	_listStart.resize(n + 1);
+
+	std::vector<task_t> tasks;
+	split(tasks, threads);
+	run(list_thread, tasks);
+
+	// pack the per-thread lists, starts were relative to each thread
+	unsigned long total = 0;
+	for (unsigned int t = 0; t != threads; ++t)
+		total += tasks[t].neighbors.size();
+	_neighbors.resize(total > 0 ? total : 1);
+
+	unsigned long offset = 0;
+	for (unsigned int t = 0; t != threads; ++t) {
+		std::copy(tasks[t].neighbors.begin(), tasks[t].neighbors.end(),
+				_neighbors.begin() + offset);
+		for (unsigned long i = tasks[t].begin; i != tasks[t].end; ++i)
+			_listStart[i] += offset;
+		offset += tasks[t].neighbors.size();
+	}
+	_listStart[n] = total;
+	_listBuilds++;
+}
+
+// pack the current positions and radii, clear the thread's buffer
+void* Mechanics::gather_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+	AgentStore& store = m->_store;
+	unsigned int sleepSteps = CONFIG::sleepSteps;
+
+	task->sleeping = 0;
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		agentHandle h = m->_handles[i];
+		bool asleep = sleepSteps != 0 && store.idleSteps(h) >= sleepSteps;
+		m->_x[i] = store.posX(h);
+		m->_y[i] = store.posY(h);
+		m->_z[i] = store.posZ(h);
+		m->_radius[i] = store.totalRadius(h);
+		m->_mobility[i] = asleep ? 0 : store.mobility(h);
+		m->_pressure[i] = 0;
+		m->_asleep[i] = asleep;
+		task->sleeping += asleep;
+	}
+
+	std::vector<double>& buffer = m->_buffers[task->index];
+	std::fill(buffer.begin(), buffer.end(), 0.0);
+	return NULL;
+}
+
+void* Mechanics::contact_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+
+	contactBlock block;
+	block.x = &m->_x[0];
+	block.y = &m->_y[0];
+	block.z = &m->_z[0];
+	block.radius = &m->_radius[0];
+	block.mobility = &m->_mobility[0];
+	block.listStart = &m->_listStart[0];
+	block.neighbors = &m->_neighbors[0];
+	block.delta = &m->_buffers[task->index][0];
+
+	task->overlap = getContactKernel()(block, task->begin, task->end);
+	return NULL;
+}
+
+/*
+ * Reduce the thread buffers into the packed positions and clear them for
+ * the next sweep; measure how far the agents are from the references.
+ */
+void* Mechanics::move_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+
+	double drift = 0;
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		double dx = 0, dy = 0, dz = 0;
+		for (std::size_t t = 0; t != m->_buffers.size(); ++t) {
+			double* delta = &m->_buffers[t][4 * i];
+			dx += delta[0];
+			dy += delta[1];
+			dz += delta[2];
+			m->_pressure[i] += delta[3];
+			delta[0] = delta[1] = delta[2] = delta[3] = 0;
+		}
+		m->_x[i] += dx;
+		m->_y[i] += dy;
+		m->_z[i] += dz;
+
+		dx = m->_x[i] - m->_refX[i];
+		dy = m->_y[i] - m->_refY[i];
+		dz = m->_z[i] - m->_refZ[i];
+		double growth = m->_radius[i] - m->_refRadius[i];
+		drift = std::max(drift,
+				sqrt(dx * dx + dy * dy + dz * dz) + std::max(growth, 0.0));
+	}
+	task->drift = drift;
+	return NULL;
+}
+
+/*
+ * Add the relaxation of the step to the agents' movement, and wake the
+ * sleeping agents that moving ones were pressed into.
+ */
+void* Mechanics::apply_thread(void* arg) {
+	task_t* task = (task_t*) arg;
+	Mechanics* m = task->mechanics;
+	AgentStore& store = m->_store;
+
+	for (unsigned long i = task->begin; i != task->end; ++i) {
+		agentHandle h = m->_handles[i];
+		if (m->_asleep[i]) {
+			double pressure = m->_pressure[i];
+			for (std::size_t t = 0; t != m->_buffers.size(); ++t)
+				pressure += m->_buffers[t][4 * i + 3];
+			if (pressure > CONFIG::wakeOverlap)
+				store.idleSteps(h) = 0;
+			continue;
+		}
+		store.deltaX(h) += m->_x[i] - store.posX(h);
+		store.deltaY(h) += m->_y[i] - store.posY(h);
+		store.deltaZ(h) += m->_z[i] - store.posZ(h);
+	}
+	return NULL;
+}
+
+// one contact sweep over the lists, returns the largest overlap it saw
+double Mechanics::sweep(std::vector<task_t>& tasks, unsigned int threads) {
+	unsigned long n = _handles.size();
+
+	// balance the contact kernel by pairs rather than by agents
+	unsigned long pairs = _listStart[n];
+	for (unsigned int t = 0; t != threads; ++t) {
+		tasks[t].begin = t == 0 ? 0 : tasks[t - 1].end;
+		tasks[t].end = t + 1 == threads ? n :
+				std::upper_bound(_listStart.begin(), _listStart.end() - 1,
+						pairs * (t + 1) / threads) - _listStart.begin();
+		tasks[t].end = std::max(tasks[t].end, tasks[t].begin);
+	}
+	run(contact_thread, tasks);
+
+	double overlap = 0;
+	for (unsigned int t = 0; t != threads; ++t)
+		overlap = std::max(overlap, tasks[t].overlap);
+	return overlap;
+}
+
+void Mechanics::resolve(unsigned int threads) {
+	unsigned long n = _handles.size();
+	if (n == 0)
+		return;
+	if (threads == 0)
+		threads = 1;
+
+	// the frozen agents never move, take them from the references
+	unsigned long total = _refX.size();
+	_x.resize(total);
+	_y.resize(total);
+	_z.resize(total);
+	_radius.resize(total);
+	_mobility.resize(total);
+	std::copy(_refX.begin() + n, _refX.end(), _x.begin() + n);
+	std::copy(_refY.begin() + n, _refY.end(), _y.begin() + n);
+	std::copy(_refZ.begin() + n, _refZ.end(), _z.begin() + n);
+	std::copy(_refRadius.begin() + n, _refRadius.end(), _radius.begin() + n);
+	std::fill(_mobility.begin() + n, _mobility.end(), 0.0);
+	_pressure.resize(n);
+	_asleep.resize(n);
+	_buffers.resize(threads);
+	for (unsigned int t = 0; t != threads; ++t)
+		_buffers[t].resize(4 * total);
+
+	std::vector<task_t> tasks;
+	split(tasks, threads);
+	run(gather_thread, tasks);
+	_sleeping = 0;
+	for (unsigned int t = 0; t != threads; ++t)
+		_sleeping += tasks[t].sleeping;
+
+	unsigned int maxSweeps = std::max(CONFIG::relaxationSweeps, 1u);
+	_converged = false;
+	for (_sweeps = 1;; ++_sweeps) {
+		double overlap = sweep(tasks, threads);
+		if (_sweeps == 1)
+			_initialOverlap = overlap;
+		_residualOverlap = overlap;
+		_converged = overlap <= CONFIG::overlapTolerance;
+		// a converged sweep leaves the agents where they are
+		if (_converged)
+			break;
+
+		split(tasks, threads);
+		run(move_thread, tasks);
+		// the residual stays the one measured before this last push
+		if (_sweeps == maxSweeps)
+			break;
+
+		// the lists only cover drifts within half the skin
+		double drift = 0;
+		for (unsigned int t = 0; t != threads; ++t)
+			drift = std::max(drift, tasks[t].drift);
+		if (2 * drift > _skin) {
+			_refX = _x;
+			_refY = _y;
+			_refZ = _z;
+			_refRadius = _radius;
+			listFromReferences(threads, false);
+		}
+	}
+
+	split(tasks, threads);
+	run(apply_thread, tasks);
+}
+
+} /* namespace BNSim */
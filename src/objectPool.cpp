@@ -0,0 +1,56 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "objectPool.h"
+
+namespace BNSim {
+
+std::atomic<unsigned int>& ObjectPoolRegistry::generation() {
+	static std::atomic<unsigned int> g(0);
+	return g;
+}
+
+std::vector<void (*)()>& ObjectPoolRegistry::pools() {
+	static std::vector<void (*)()> p;
+	return p;
+}
+
+std::mutex& ObjectPoolRegistry::locker() {
+	static std::mutex m;
+	return m;
+}
+
+void ObjectPoolRegistry::add(void (*release)()) {
+	mutexLock lock(locker());
+	pools().push_back(release);
+}
+
+/*
+ * Hand every slab back to the system. Thread caches notice the generation
+ * change and drop their (now dangling) free lists on next use.
+ */
+void ObjectPoolRegistry::releaseAll() {
+	mutexLock lock(locker());
+	for (std::size_t i = 0; i != pools().size(); ++i)
+		pools()[i]();
+	generation().fetch_add(1);
+}
+
+} /* namespace BNSim */
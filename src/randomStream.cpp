@@ -0,0 +1,76 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "randomStream.h"
+#include <atomic>
+
+namespace BNSim {
+
+static std::atomic<unsigned long long> streamCount(0);
+
+// splitmix64, turns consecutive seeds into well mixed generator states
+static unsigned long long mix(unsigned long long& x) {
+	unsigned long long z = (x += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+RandomStream::RandomStream(unsigned long long seed) :
+		_lane(0) {
+	for (unsigned int l = 0; l != kLanes; ++l) {
+		_s0[l] = mix(seed);
+		_s1[l] = mix(seed);
+	}
+}
+
+void RandomStream::fill(double* u, unsigned long n) {
+	unsigned long i = 0;
+	for (; i + kLanes <= n; i += kLanes)
+		for (unsigned int l = 0; l != kLanes; ++l)
+			u[i + l] = toUniform(step(_s0[l], _s1[l]));
+	for (; i != n; ++i)
+		u[i] = next();
+}
+
+double RandomStream::next() {
+	_lane = (_lane + 1) % kLanes;
+	return toUniform(step(_s0[_lane], _s1[_lane]));
+}
+
+void RandomStream::seed(unsigned long long seed, unsigned long long step,
+		unsigned int stream) {
+	unsigned long long x = mix(seed) ^ step;
+	x = mix(x) ^ stream;
+	_lane = 0;
+	for (unsigned int l = 0; l != kLanes; ++l) {
+		_s0[l] = mix(x);
+		_s1[l] = mix(x);
+	}
+}
+
+// until seeded, a thread's stream follows the order of first use
+RandomStream& RandomStream::local() {
+	static thread_local RandomStream stream(
+			0x853c49e6748fea9bull + 0x632be59bd9b4e019ull * streamCount++);
+	return stream;
+}
+
+} /* namespace BNSim */
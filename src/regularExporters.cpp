@@ -50,13 +50,14 @@ void regularExporters::dump_QS_Status(ofstream& QSStatus) {
 	double LuxR = 0, LuxC = 0, AI = 0;
 	int clk = (int) (CONFIG::time);
 
-	for (unsigned int i = 0; i != CONFIG::universe->getTotalAgentNumber();
-			++i,++count) {
-		Agent* agent = CONFIG::universe->getAgent(i);
-		QSLux* qs = (QSLux*) agent->getRegulatoryNet("QSLux");
-		LuxR += qs->getR1();
-		LuxC += qs->getC1();
-		AI += qs->getA1();
+	// every QS network of the population, agents without one are skipped
+	unsigned long n = componentCount<QSLux>();
+	const double* state = componentState<QSLux>();
+	for (unsigned long i = 0; i != n; ++i, state += QSLux::stateWidth) {
+		count++;
+		LuxR += state[QSLux::stateR1];
+		LuxC += state[QSLux::stateC1];
+		AI += state[QSLux::stateA1];
 	}
 
 	QSStatus<<clk<<","<<count<<","<<LuxR/count<<","<<LuxC/count<<","<<AI/count<<endl;
@@ -68,17 +69,27 @@ void regularExporters::dump_Metabolism_Status(ofstream& MetaStatus) {
 	double substrate = 0, u=0;
 	int clk = (int) (CONFIG::time);
 
-	for (unsigned int i = 0; i != CONFIG::universe->getTotalAgentNumber();
-			++i,++count) {
-		Agent* agent = CONFIG::universe->getAgent(i);
-		SimpleMetabolism* meta = (SimpleMetabolism*) agent->getRegulatoryNet("SimpleMetabolism");
-		substrate += meta->getS();
-		u += meta->getU();
+	unsigned long n = componentCount<SimpleMetabolism>();
+	const double* state = componentState<SimpleMetabolism>();
+	for (unsigned long i = 0; i != n; ++i, state += SimpleMetabolism::stateWidth) {
+		count++;
+		substrate += state[SimpleMetabolism::stateS];
+		u += state[SimpleMetabolism::stateU];
 	}
 
 	MetaStatus<<clk<<","<<count<<","<<substrate/count<<","<<u/count<<endl;
 }
 
+// contact relaxation of the last step
+void regularExporters::dump_Mechanics_Status(ofstream& MechStatus) {
+
+	const Mechanics& mech = CONFIG::universe->getMechanics();
+	int clk = (int) (CONFIG::time);
+
+	MechStatus<<clk<<","<<mech.getPairCount()<<","<<mech.getListBuilds()<<","<<mech.getSweeps()
+			<<","<<mech.getInitialOverlap()<<","<<mech.getResidualOverlap()<<","<<mech.isConverged()<<","<<mech.getSleepingCount()<<endl;
+}
+
 void regularExporters::dump_Agent() {
 	char file_name[100];
 	int clk = (int) (CONFIG::time);
@@ -106,7 +117,10 @@ void regularExporters::export_agent_position(ofstream& output_file) {
 	output_file << int(CONFIG::time) << " ";
 	
 	for (int i = 0; i < CONFIG::universe->getTotalAgentNumber(); i++) {
-		myVector3d abs_pos = CONFIG::universe->getAgent(i)->getabsPosition();
+		Agent* agent = CONFIG::universe->getAgent(i);
+		if (agent == NULL)
+			continue;
+		myVector3d abs_pos = agent->getabsPosition();
 		
 		output_file << abs_pos.pos.x << " " << abs_pos.pos.y << " " 
 					<< abs_pos.pos.z << " ";
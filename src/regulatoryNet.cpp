@@ -22,12 +22,13 @@
 
 namespace BNSim {
 
-RegulatoryNet::RegulatoryNet(Agent* host):_host(host) {
+RegulatoryNet::RegulatoryNet(Agent* host) :
+		_host(host), _componentType(invalidComponent), _denseIndex(notAttached) {
 
 }
 
 RegulatoryNet::~RegulatoryNet() {
-
+	ComponentRegistry::detach(this);
 }
 
 } /* namespace BNSim */
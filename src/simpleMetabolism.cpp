@@ -22,9 +22,24 @@
 
 namespace BNSim {
 
-SimpleMetabolism::SimpleMetabolism(Agent* host) :
-		RegulatoryNet(host) {
+MetabolismParams::MetabolismParams() :
+		m(0), u_PG(0), u_PGMax(0), Y(0), u_max(0), Ks(0), Kc(0) {
+}
+
+const MetabolismParams& MetabolismParams::defaults() {
+	static const MetabolismParams params;
+	return params;
+}
+
+SimpleMetabolism::SimpleMetabolism(Agent* host,
+		const MetabolismParams* params) :
+		RegulatoryNet(host), _params(params), _u(0), _qs(NULL), _s(0) {
             name = "SimpleMetabolism";
+	substrate = -1;
+}
+
+void SimpleMetabolism::bindSpecies() {
+	substrate = CONFIG::universe->getMoleculeIndex("substrate");
 }
 
 SimpleMetabolism::~SimpleMetabolism() {
@@ -36,35 +51,40 @@ double SimpleMetabolism::randomUniform() {
 
 void SimpleMetabolism::update() {
 
-	int substrate = -1;
-	substrate =
-			CONFIG::universe->getMoleculeInfo("substrate") == NULL ?
-					-1 :
-					CONFIG::universe->getMoleculeInfo("substrate")->getIndex();
-
 	intVector3d GPos = getHost()->getGridPos();
 	Grid* myGrid = CONFIG::universe->getGrid(GPos.x, GPos.y, GPos.z);
 	double timestep = CONFIG::timestep;
+	const MetabolismParams& p = *_params;
 
 	// input to the system
 
     _s = myGrid->getConc(substrate);
     double C = _qs->getC1();
-    double X = getHost()->getMass("X");
-    //	double eps = getHost()->getMass("EPS");
+    double X = getHost()->getMass(biomassSlot);
+    //	double eps = getHost()->getMass(epsSlot);
  
-    _u = ((_u_max - _u_PG) * _s / (_s + _Ks) - _m)*timestep;
+    _u = ((p.u_max - p.u_PG) * _s / (_s + p.Ks) - p.m)*timestep;
     double deltaX = _u * X+0.1*_u * X*(randomUniform()-0.5);
     
-    double consume =( (_u_max + _u_PG) * _s / (_s + _Ks) + _m)*X*timestep;
+    double consume =( (p.u_max + p.u_PG) * _s / (_s + p.Ks) + p.m)*X*timestep;
     
     X += deltaX;
     // consume substrate
     myGrid->consumeChemical(substrate, consume);
     
     // let's set the mass
-    getHost()->updateMass("X",X);
-    //	getHost()->updateMass("EPS",eps);
+    getHost()->updateMass(biomassSlot, X);
+    //	getHost()->updateMass(epsSlot, eps);
+
+    publishState();
+}
+
+void SimpleMetabolism::publishState() {
+	double* row = stateRow();
+	if (row == NULL)
+		return;
+	row[stateS] = _s;
+	row[stateU] = _u;
 }
 
 } /* namespace BNSim */
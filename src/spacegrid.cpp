@@ -31,7 +31,6 @@ Grid::Grid(const int gridIndex):_gridIndex(gridIndex)
 	for(unsigned int i = 0; i != CONFIG::numberMoleculeSpecies; ++i)
 		_moleculeSpeciesConc[i] = 0;
 
-	_agents = new BNSimVector<Agent*>();
 	_type = bulk;   // all grids initialized to bulk type
 
 	volume = CONFIG::gridSizeZ*CONFIG::gridSizeY*CONFIG::gridSizeZ;
@@ -40,11 +39,6 @@ Grid::Grid(const int gridIndex):_gridIndex(gridIndex)
 
 Grid::~Grid()
 {
-    for(unsigned int i = 0; i!= _agents->getSize();++i) {
-		delete (*_agents)[i];
-	}
-
-	delete _agents;
 	delete [] _moleculeSpeciesConc;
 }
 
@@ -77,15 +71,7 @@ void Grid::consumeChemical(const unsigned int moleculeSpeciesIndex, const double
         _moleculeSpeciesConc[moleculeSpeciesIndex] = 0;
 }
 
-void Grid::addAgent(Agent* p)
+const std::size_t Grid::getAgentNumber()
 {
-	mutexLock lock(locker);
-
-	_agents->add(p);
-}
-
-void Grid::deleteAgent(Agent* p)
-{
-    mutexLock lock(locker);
-	(*_agents).remove(p);
+	return CONFIG::universe->getOccupancy().getCount(_gridIndex);
 }
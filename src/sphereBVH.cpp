@@ -0,0 +1,141 @@
+/**
+ * BNSim is an open-source, parallel, stochastic, and multi-scale modeling
+ * platform which integrates various simulation algorithms, together with
+ * chemotaixs, quorum sensing, and biofilm models in a 3D environment.
+ *
+ * BNSim is developed by CMU SLD Group, and released under GPLv2 license
+ * Please check http://www.ece.cmu.edu/~sld/ for more information
+ *
+ * BNSim is developed using C++ and pthread under Linux and Mac OS
+ *
+ * If you use it or part of it for your work, please cite
+ * Wei, Guopeng, Paul Bogdan, and Radu Marculescu. "Efficient Modeling and
+ * Simulation of Bacteria-Based Nanonetworks with BNSim." Selected Areas in
+ * Communications, IEEE Journal on 31.12 (2013): 868-878.
+ *
+ * @author      Guopeng (Daniel) Wei  1@weiguopeng.com
+ * @version     2.0
+ * @since       1.0
+ */
+
+#include "sphereBVH.h"
+#include <algorithm>
+
+namespace BNSim {
+
+SphereBVH::SphereBVH() :
+		_cost(0) {
+}
+
+double SphereBVH::surface(const node_t& node) {
+	double a = node.hi[0] - node.lo[0];
+	double b = node.hi[1] - node.lo[1];
+	double c = node.hi[2] - node.lo[2];
+	return 2 * (a * b + b * c + c * a);
+}
+
+void SphereBVH::boxItems(node_t& node, const double* x, const double* y,
+		const double* z, const double* radius, double margin) {
+	for (unsigned int a = 0; a != 3; ++a) {
+		node.lo[a] = 1e300;
+		node.hi[a] = -1e300;
+	}
+	for (unsigned int k = node.first; k != node.first + node.count; ++k) {
+		unsigned int i = _items[k];
+		double r = radius[i] + margin;
+		node.lo[0] = std::min(node.lo[0], x[i] - r);
+		node.hi[0] = std::max(node.hi[0], x[i] + r);
+		node.lo[1] = std::min(node.lo[1], y[i] - r);
+		node.hi[1] = std::max(node.hi[1], y[i] + r);
+		node.lo[2] = std::min(node.lo[2], z[i] - r);
+		node.hi[2] = std::max(node.hi[2], z[i] + r);
+	}
+}
+
+/*
+ * Top-down build: split the items at the median center along the longest
+ * axis of their centers. Median splits keep the depth at log2(n / leaf).
+ */
+void SphereBVH::split(unsigned int node, unsigned int begin, unsigned int end,
+		unsigned int depth) {
+	if (end - begin <= kLeafSize || depth == 60) {
+		_nodes[node].first = begin;
+		_nodes[node].count = end - begin;
+		return;
+	}
+
+	double lo[3] = { 1e300, 1e300, 1e300 }, hi[3] = { -1e300, -1e300, -1e300 };
+	for (unsigned int k = begin; k != end; ++k) {
+		const double* c = &_centers[3 * _items[k]];
+		for (unsigned int a = 0; a != 3; ++a) {
+			lo[a] = std::min(lo[a], c[a]);
+			hi[a] = std::max(hi[a], c[a]);
+		}
+	}
+	unsigned int axis = 0;
+	for (unsigned int a = 1; a != 3; ++a)
+		if (hi[a] - lo[a] > hi[axis] - lo[axis])
+			axis = a;
+
+	const std::vector<double>& centers = _centers;
+	unsigned int middle = begin + (end - begin) / 2;
+	std::nth_element(_items.begin() + begin, _items.begin() + middle,
+			_items.begin() + end,
+			[&centers, axis](unsigned int a, unsigned int b) {
+				return centers[3 * a + axis] < centers[3 * b + axis];
+			});
+
+	unsigned int left = _nodes.size();
+	_nodes[node].first = left;
+	_nodes[node].count = 0;
+	_nodes.resize(left + 2);
+	split(left, begin, middle, depth + 1);
+	split(left + 1, middle, end, depth + 1);
+}
+
+void SphereBVH::build(const double* x, const double* y, const double* z,
+		const double* radius, unsigned long n, double margin) {
+	_items.resize(n);
+	_centers.resize(3 * n);
+	for (unsigned long i = 0; i != n; ++i) {
+		_items[i] = i;
+		_centers[3 * i] = x[i];
+		_centers[3 * i + 1] = y[i];
+		_centers[3 * i + 2] = z[i];
+	}
+
+	_nodes.clear();
+	if (n == 0) {
+		_cost = 0;
+		return;
+	}
+	_nodes.reserve(2 * (n / kLeafSize + 1));
+	_nodes.resize(1);
+	split(0, 0, n, 0);
+	refit(x, y, z, radius, margin);
+}
+
+/*
+ * Children are always stored after their parent, so one reverse pass over
+ * the nodes recomputes every box from the bottom up.
+ */
+void SphereBVH::refit(const double* x, const double* y, const double* z,
+		const double* radius, double margin) {
+	_cost = 0;
+	for (std::size_t k = _nodes.size(); k-- != 0;) {
+		node_t& node = _nodes[k];
+		if (node.count != 0) {
+			boxItems(node, x, y, z, radius, margin);
+		} else {
+			const node_t& left = _nodes[node.first];
+			const node_t& right = _nodes[node.first + 1];
+			for (unsigned int a = 0; a != 3; ++a) {
+				node.lo[a] = std::min(left.lo[a], right.lo[a]);
+				node.hi[a] = std::max(left.hi[a], right.hi[a]);
+			}
+		}
+		_cost += surface(node);
+	}
+}
+
+} /* namespace BNSim */
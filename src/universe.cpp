@@ -19,6 +19,8 @@
  */
 
 #include "universe.h"
+#include "randomStream.h"
+#include <algorithm>
 
 namespace BNSim {
 
@@ -35,8 +37,27 @@ std::string CONFIG::workdir = "";
 Universe* CONFIG::universe = NULL;
 unsigned int CONFIG::boundaryLayerThickness = 0;
 bool CONFIG::diffusion = true;
-
-Universe::Universe() {
+unsigned int CONFIG::compactionInterval = 0;
+bool CONFIG::spatialCompaction = false;
+bool CONFIG::mortonGrids = false;
+double CONFIG::verletSkin = 0.5;
+unsigned int CONFIG::relaxationSweeps = 1;
+double CONFIG::overlapTolerance = 0;
+bool CONFIG::contactBVH = false;
+unsigned int CONFIG::sleepSteps = 0;
+double CONFIG::sleepDisplacement = 0.01;
+double CONFIG::wakeOverlap = 0.1;
+bool CONFIG::freezeInactive = false;
+bool CONFIG::eventMotor = false;
+bool CONFIG::fastChemotaxisMath = false;
+bool CONFIG::fastRadiusMath = false;
+unsigned long long CONFIG::randomSeed = 1;
+
+// index of the worker thread running the current agent phase
+static thread_local unsigned int workerIndex = 0;
+
+Universe::Universe() :
+		_mechanics(_store, _frozen) {
 
 	// Calculate some constants that are useful
 
@@ -47,6 +68,7 @@ Universe::Universe() {
 			* CONFIG::gridNumberZ;
 
 	// Add the grids
+	number_grids();
 
 	unsigned int i = 0;
 	while (i++ < gridNum) {
@@ -60,11 +82,25 @@ Universe::Universe() {
 
 	CONFIG::universe = this;
 	IDcounts = 0;
-	_Agents.setCapacity(10000000);
+	_deferring = false;
+	_occupancyDirty = true;
+	_populationChanged = true;
+	_steps = 0;
+	// agents made during set-up draw from the stream after the workers'
+	RandomStream::local().seed(CONFIG::randomSeed, 0, CONFIG::threadNumber);
+	_birthQueues.resize(CONFIG::threadNumber);
+	_deathQueues.resize(CONFIG::threadNumber);
+	_freezeQueues.resize(CONFIG::threadNumber);
+	_birthOffsets.resize(CONFIG::threadNumber);
 }
 
 Universe::~Universe() {
 
+	// Release agents
+	for (unsigned long i = 0; i != _Agents.getSize(); ++i) {
+		delete _Agents[i];
+	}
+
 	// Release maps
 	for (std::map<std::string, MoleculeInfo*>::iterator itr =
 			_moleculeMAP.begin(); itr != _moleculeMAP.end(); ++itr) {
@@ -80,6 +116,9 @@ Universe::~Universe() {
 	}
 
 	_Grids.clear();
+
+	// All agents, networks and mass records are gone, drop the pool slabs
+	ObjectPoolRegistry::releaseAll();
 }
 
 void * environment_thread(void *arg) {
@@ -412,44 +451,79 @@ void * environment_thread(void *arg) {
 	pthread_exit(NULL);
 }
 
-void * agent_thread(void *arg) {
+/*
+ * Update the agents of this thread's range of the batch order. The range is
+ * split into runs of a single agent type, each run is shuffled and handed
+ * to the statically dispatched kernel of its type.
+ */
+void * Universe::agent_thread(void *arg) {
 	thread_data_t *data = (thread_data_t *) arg;
+	workerIndex = data->index;
+
+	Universe* universe = CONFIG::universe;
+	Agent** batch = universe->_batch.empty() ? NULL : &universe->_batch[0];
+	RandomStream& random = RandomStream::local();
+	random.seed(CONFIG::randomSeed, universe->_steps, workerIndex);
+
+	for (unsigned int type = 0; type + 1 < universe->_typeStart.size();
+			++type) {
+		unsigned int start = std::max(data->start, universe->_typeStart[type]);
+		unsigned int end = std::min(data->end,
+				universe->_typeStart[type + 1]);
+		if (start >= end)
+			continue;
+
+		// shuffled from the thread's stream, so the order is reproducible
+		for (unsigned int i = 0; i != end - start; ++i) {
+			size_t j = i + (size_t) (random.next() * ((end - start) - i));
+			Agent* t = batch[start + j];
+			batch[start + j] = batch[start + i];
+			batch[start + i] = t;
+		}
 
-	unsigned int order[data->end - data->start];
-
-	for (unsigned int i = data->start; i != data->end; ++i)
-		order[i - data->start] = i;
-
-	for (unsigned int i = 0; i != (data->end - data->start); ++i) {
-		size_t j = i
-				+ rand() / (RAND_MAX / ((data->end - data->start) - i) + 1);
-		int t = order[j];
-		order[j] = order[i];
-		order[i] = t;
-	}
-
-	for (unsigned int i = data->start; i != data->end; ++i) {
-		unsigned int id = order[i - data->start];
-		Agent * age = CONFIG::universe->getAgent(id);
-		if (age != NULL)
-			age->update();
+		AgentTypeRegistry::getKernel(type)(batch + start, end - start);
 	}
 	pthread_exit(NULL);
 }
 
 // Handle agent delta movement
 
-void * post_agent_thread(void *arg) {
+void * Universe::post_agent_thread(void *arg) {
 	thread_data_t *data = (thread_data_t *) arg;
+	Universe* universe = CONFIG::universe;
+	Agent** batch = universe->_batch.empty() ? NULL : &universe->_batch[0];
 
-	for (unsigned int i = data->start; i != data->end; ++i) {
-		if (CONFIG::universe->getAgent(i) != NULL)
-			CONFIG::universe->getAgent(i)->pos_update();
-	}
+	for (unsigned int i = data->start; i != data->end; ++i)
+		batch[i]->pos_update();
 
 	pthread_exit(NULL);
 }
 
+/*
+ * Group the live agents by type (counting sort on the type tag) so that
+ * each thread updates long runs of agents of the same concrete type.
+ */
+void Universe::build_batches() {
+	unsigned int types = AgentTypeRegistry::getTypeCount();
+	_typeStart.assign(types + 1, 0);
+
+	for (unsigned long i = 0; i != _Agents.getSize(); ++i) {
+		Agent* agent = _Agents[i];
+		if (agent != NULL)
+			_typeStart[_store.type(agent->getHandle()) + 1]++;
+	}
+	for (unsigned int t = 0; t != types; ++t)
+		_typeStart[t + 1] += _typeStart[t];
+
+	_batch.resize(_typeStart[types]);
+	std::vector<unsigned int> fill(_typeStart.begin(), _typeStart.end() - 1);
+	for (unsigned long i = 0; i != _Agents.getSize(); ++i) {
+		Agent* agent = _Agents[i];
+		if (agent != NULL)
+			_batch[fill[_store.type(agent->getHandle())]++] = agent;
+	}
+}
+
 void Universe::update_agent_parallel() {
 
 	unsigned int i;
@@ -478,6 +552,9 @@ void Universe::update_agent_parallel() {
 		pthread_join(thr[i], NULL);
 	}
 
+	// mechanics phase, every contacting pair once
+	_mechanics.resolve(CONFIG::threadNumber);
+
 	for (i = 0; i != CONFIG::threadNumber; ++i) {
 		if ((rc = pthread_create(&thr[i], NULL, post_agent_thread,
 				&thr_data[order[i]]))) {
@@ -520,12 +597,16 @@ void Universe::update_environment_p() {
 }
 
 void Universe::prepare_multithreading() {
-	unsigned int threadstep = CONFIG::universe->getTotalAgentNumber()
-			/ CONFIG::threadNumber;
+	build_batches();
+
+	unsigned int threadstep = _batch.size() / CONFIG::threadNumber;
 	unsigned int envthreadstep = CONFIG::gridNumberX / CONFIG::threadNumber;
 
 	// prepare data-structure
 
+	for (unsigned int i = 0; i < CONFIG::threadNumber; ++i)
+		thr_data[i].index = evn_thr_data[i].index = i;
+
 	for (unsigned int i = 0; i < CONFIG::threadNumber - 1; ++i) {
 		thr_data[i].start = i * threadstep;
 		thr_data[i].end = (i + 1) * threadstep;
@@ -536,17 +617,191 @@ void Universe::prepare_multithreading() {
 	}
 	thr_data[CONFIG::threadNumber - 1].start =
 			thr_data[CONFIG::threadNumber - 2].end;
-	thr_data[CONFIG::threadNumber - 1].end =
-			CONFIG::universe->getTotalAgentNumber();
+	thr_data[CONFIG::threadNumber - 1].end = _batch.size();
 
 	evn_thr_data[CONFIG::threadNumber - 1].start =
 			evn_thr_data[CONFIG::threadNumber - 2].end;
 	evn_thr_data[CONFIG::threadNumber - 1].end = CONFIG::gridNumberX;
 }
 
+unsigned int Universe::getWorkerIndex() {
+	return workerIndex;
+}
+
+/*
+ * Outside of a step agents join the universe immediately. During a step
+ * they are queued by the calling worker and committed in one batch.
+ */
+void Universe::addAgent(Agent* agent) {
+	if (_deferring) {
+		_birthQueues[workerIndex].push_back(agent);
+		return;
+	}
+	agent->attachToUniverse(IDcounts++);
+	_Agents.add(agent);
+	_occupancyDirty = _populationChanged = true;
+}
+
+void Universe::removeAgent(Agent* agent) {
+	if (_deferring) {
+		_deathQueues[workerIndex].push_back(agent);
+		return;
+	}
+	agent->detachFromUniverse();
+	_Agents.remove(agent);
+	delete agent;
+	_occupancyDirty = _populationChanged = true;
+}
+
+void Universe::freezeAgent(Agent* agent) {
+	if (_deferring) {
+		_freezeQueues[workerIndex].push_back(agent);
+		return;
+	}
+	freeze(agent);
+	_occupancyDirty = _populationChanged = true;
+}
+
+/*
+ * Only the position and size of a frozen agent are kept; deleting the
+ * agent frees its networks and its row in the agent store.
+ */
+void Universe::freeze(Agent* agent) {
+	agentHandle h = agent->getHandle();
+	_frozen.add(_store.posX(h), _store.posY(h), _store.posZ(h),
+			_store.totalRadius(h));
+	agent->detachFromUniverse();
+	_Agents.remove(agent);
+	delete agent;
+}
+
+void * Universe::commit_thread(void *arg) {
+	thread_data_t *data = (thread_data_t *) arg;
+	Universe* universe = CONFIG::universe;
+	std::vector<Agent*>& queue = universe->_birthQueues[data->index];
+	unsigned long offset = universe->_birthOffsets[data->index];
+
+	for (std::size_t i = 0; i != queue.size(); ++i) {
+		queue[i]->attachToUniverse(universe->IDcounts + offset + i);
+		universe->_Agents.place(universe->_birthSlots[offset + i], queue[i]);
+	}
+	queue.clear();
+
+	pthread_exit(NULL);
+}
+
+/*
+ * Commit the births and deaths queued during the agent phase: IDs and
+ * storage slots are assigned for all new borns at once, then each worker
+ * queue is registered with the grids in parallel. The agent list is
+ * compacted afterwards when it got sparse or the interval is due.
+ */
+void Universe::commit_population_changes() {
+	unsigned long births = 0;
+	for (unsigned int i = 0; i != CONFIG::threadNumber; ++i) {
+		_birthOffsets[i] = births;
+		births += _birthQueues[i].size();
+	}
+
+	if (births != 0) {
+		_Agents.reserveSlots(births, _birthSlots);
+
+		for (unsigned int i = 0; i != CONFIG::threadNumber; ++i) {
+			if (pthread_create(&thr[i], NULL, commit_thread, &thr_data[i]))
+				return;
+		}
+		for (unsigned int i = 0; i != CONFIG::threadNumber; ++i) {
+			pthread_join(thr[i], NULL);
+		}
+		IDcounts += births;
+		_populationChanged = true;
+	}
+
+	for (unsigned int i = 0; i != CONFIG::threadNumber; ++i) {
+		std::vector<Agent*>& queue = _deathQueues[i];
+		if (!queue.empty())
+			_populationChanged = true;
+		for (std::size_t j = 0; j != queue.size(); ++j) {
+			queue[j]->detachFromUniverse();
+			_Agents.remove(queue[j]);
+			delete queue[j];
+		}
+		queue.clear();
+	}
+
+	for (unsigned int i = 0; i != CONFIG::threadNumber; ++i) {
+		std::vector<Agent*>& queue = _freezeQueues[i];
+		if (!queue.empty())
+			_populationChanged = true;
+		for (std::size_t j = 0; j != queue.size(); ++j)
+			freeze(queue[j]);
+		queue.clear();
+	}
+
+	_steps++;
+	if (_Agents.needsCompaction()
+			|| (CONFIG::compactionInterval != 0
+					&& _steps % CONFIG::compactionInterval == 0))
+		compact();
+}
+
+/*
+ * Squeeze the tombstones out of the agent list. In spatial order the rows
+ * of the agent store follow the list, so agents close in space are also
+ * close in memory, and the contact lists are rebuilt in the new order.
+ */
+void Universe::compact() {
+	_Agents.compact(CONFIG::spatialCompaction);
+	if (!CONFIG::spatialCompaction)
+		return;
+
+	std::vector<agentHandle> order(_Agents.getSize());
+	for (unsigned long i = 0; i != order.size(); ++i)
+		order[i] = _Agents[i]->getHandle();
+	_store.reorder(order.empty() ? NULL : &order[0], order.size());
+	_occupancyDirty = _populationChanged = true;
+}
+
+/*
+ * Rebuild the per-grid agent lists from the grid cell of every live agent,
+ * and rebin the agents for contact search.
+ */
+void Universe::rebuild_occupancy() {
+	unsigned long n = _Agents.getSize();
+	_occupancyKeys.resize(n);
+	_occupancyItems.resize(n);
+	_liveHandles.clear();
+
+	for (unsigned long i = 0; i != n; ++i) {
+		Agent* agent = _Agents[i];
+		if (agent == NULL) {
+			_occupancyKeys[i] = noCell;
+			continue;
+		}
+		_occupancyItems[i] = agent->getHandle();
+		_occupancyKeys[i] = _store.gridCell(_occupancyItems[i]);
+		_liveHandles.push_back(_occupancyItems[i]);
+	}
+
+	_occupancy.build(_Grids.size(), n == 0 ? NULL : &_occupancyKeys[0],
+			n == 0 ? NULL : &_occupancyItems[0], n, CONFIG::threadNumber);
+	_mechanics.refresh(_liveHandles.empty() ? NULL : &_liveHandles[0],
+			_liveHandles.size(), CONFIG::threadNumber, _populationChanged);
+	_occupancyDirty = false;
+	_populationChanged = false;
+}
+
 void Universe::evolute() {
+	if (_occupancyDirty)
+		rebuild_occupancy();
+
 	prepare_multithreading();
+
+	_deferring = true;
 	update_agent_parallel();
+	_deferring = false;
+	commit_population_changes();
+	rebuild_occupancy();
 
 	if (CONFIG::diffusion)
 		update_environment_p();
@@ -554,11 +809,41 @@ void Universe::evolute() {
 	CONFIG::time += CONFIG::timestep;
 }
 
-Grid* Universe::getGrid(unsigned int x, unsigned int y, unsigned int z) {
-	return _Grids[x * CONFIG::gridNumberY * CONFIG::gridNumberZ
+unsigned int Universe::getGridIndex(unsigned int x, unsigned int y,
+		unsigned int z) {
+	return _gridIndex[x * CONFIG::gridNumberY * CONFIG::gridNumberZ
 			+ y * CONFIG::gridNumberZ + z];
 }
 
+/*
+ * Number the grids row by row, or in Z-order with CONFIG::mortonGrids so
+ * that grids next to each other in space are also close in memory.
+ */
+void Universe::number_grids() {
+	std::size_t gridNum = CONFIG::gridNumberX * CONFIG::gridNumberY
+			* CONFIG::gridNumberZ;
+	_gridIndex.resize(gridNum);
+	if (!CONFIG::mortonGrids) {
+		for (unsigned int i = 0; i != gridNum; ++i)
+			_gridIndex[i] = i;
+		return;
+	}
+
+	std::vector<std::pair<unsigned long long, unsigned int> > order(gridNum);
+	unsigned int i = 0;
+	for (unsigned int x = 0; x != CONFIG::gridNumberX; ++x)
+		for (unsigned int y = 0; y != CONFIG::gridNumberY; ++y)
+			for (unsigned int z = 0; z != CONFIG::gridNumberZ; ++z, ++i)
+				order[i] = std::make_pair(mortonKey(x, y, z), i);
+	std::sort(order.begin(), order.end());
+	for (i = 0; i != gridNum; ++i)
+		_gridIndex[order[i].second] = i;
+}
+
+Grid* Universe::getGrid(unsigned int x, unsigned int y, unsigned int z) {
+	return _Grids[getGridIndex(x, y, z)];
+}
+
 const MoleculeInfo* Universe::getMoleculeInfo(const std::string& name) {
 	std::map<std::string, MoleculeInfo*>::iterator it = _moleculeMAP.find(name);
 
@@ -569,6 +854,11 @@ const MoleculeInfo* Universe::getMoleculeInfo(const std::string& name) {
 		return NULL;
 }
 
+int Universe::getMoleculeIndex(const std::string& name) {
+	const MoleculeInfo* info = getMoleculeInfo(name);
+	return info == NULL ? -1 : info->getIndex();
+}
+
 const MoleculeInfo* Universe::getMoleculeInfo(const unsigned int index) {
 	std::map<unsigned int, MoleculeInfo*>::iterator it =
 			_moleculeMAPIndexed.find(index);